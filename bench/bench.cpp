@@ -0,0 +1,164 @@
+#include "nichess/nichess.hpp"
+#include "nichess/perft.hpp"
+#include "benchpositions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+/*
+ * Perft benchmark over a fixed suite of positions. Every count is checked against the stored
+ * reference values, and the timing of repeated runs is reported as nodes per second.
+ *
+ *   nichess_bench [--depth N] [--runs N] [--threads N] [--position NAME] [--csv]
+ *
+ * Exits with 1 if any count differs from its reference value.
+ */
+
+class BenchPosition {
+  public:
+    std::string name;
+    std::string encodedBoard; // empty string means the starting position
+    int defaultDepth;
+    std::vector<unsigned long long> referenceNodes; // referenceNodes[d-1] is perft(d)
+};
+
+static const std::vector<BenchPosition> benchPositions = {
+  {
+    "opening",
+    "",
+    4,
+    {42, 1775, 78765, 3771628, 215362908}
+  },
+  // positions from legalactionstest
+  {
+    "legalactions-1",
+    LEGAL_ACTIONS_1,
+    4,
+    {84, 4819, 348480, 17460726, 1169320699}
+  },
+  {
+    "legalactions-2",
+    LEGAL_ACTIONS_2,
+    4,
+    {46, 1992, 97162, 5106689}
+  },
+  // mages next to groups of enemy pieces, most abilities hit several pieces
+  {
+    "mage-splash-1",
+    MAGE_SPLASH_1,
+    3,
+    {148, 15946, 2242113, 282127199}
+  },
+  {
+    "mage-splash-2",
+    MAGE_SPLASH_2,
+    3,
+    {136, 10549, 1556725, 126766128}
+  },
+};
+
+class BenchOptions {
+  public:
+    int depth = 0; // 0 means each position's default depth
+    int runs = 5;
+    int threads = 1;
+    std::string position;
+    bool csv = false;
+};
+
+static void printUsage(const char* program) {
+  printf("Usage: %s [--depth N] [--runs N] [--threads N] [--position NAME] [--csv]\n", program);
+  printf("  --depth N        perft depth for every position (default: per position)\n");
+  printf("  --runs N         timed runs per position (default: 5)\n");
+  printf("  --threads N      use perftParallel with N threads, 0 for all cores (default: 1, serial perft)\n");
+  printf("  --position NAME  only run this position\n");
+  printf("  --csv            machine-readable output, one line per position\n");
+  printf("Positions:");
+  for(const BenchPosition& bp: benchPositions) {
+    printf(" %s", bp.name.c_str());
+  }
+  printf("\n");
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+  for(int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if(arg == "--depth" && hasValue) {
+      options.depth = std::atoi(argv[++i]);
+    } else if(arg == "--runs" && hasValue) {
+      options.runs = std::atoi(argv[++i]);
+    } else if(arg == "--threads" && hasValue) {
+      options.threads = std::atoi(argv[++i]);
+    } else if(arg == "--position" && hasValue) {
+      options.position = argv[++i];
+    } else if(arg == "--csv") {
+      options.csv = true;
+    } else {
+      return false;
+    }
+  }
+  return options.depth >= 0 && options.runs >= 1 && options.threads >= 0;
+}
+
+int main(int argc, char* argv[]) {
+  BenchOptions options;
+  if(!parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  GameCache cache = GameCache();
+  bool allCorrect = true;
+  bool anyPosition = false;
+  if(options.csv) {
+    printf("position,depth,threads,nodes,reference,status,runs,min_nps,median_nps,max_nps\n");
+  } else {
+    printf("%-16s %5s %12s %10s %14s %14s %14s\n", "position", "depth", "nodes", "status", "min nps", "median nps", "max nps");
+  }
+  for(const BenchPosition& bp: benchPositions) {
+    if(!options.position.empty() && options.position != bp.name) continue;
+    anyPosition = true;
+    Game game = bp.encodedBoard.empty() ? Game(cache) : Game(cache, bp.encodedBoard);
+    int depth = options.depth > 0 ? options.depth : bp.defaultDepth;
+
+    unsigned long long nodes = 0;
+    std::vector<double> nodesPerSecond;
+    for(int run = 0; run < options.runs; run++) {
+      auto start = std::chrono::steady_clock::now();
+      nodes = options.threads == 1 ? perft(game, depth) : perftParallel(game, depth, options.threads);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      nodesPerSecond.push_back(seconds > 0 ? nodes / seconds : 0);
+    }
+    std::sort(nodesPerSecond.begin(), nodesPerSecond.end());
+
+    bool hasReference = depth <= (int) bp.referenceNodes.size();
+    unsigned long long reference = hasReference ? bp.referenceNodes[depth-1] : 0;
+    const char* status = !hasReference ? "unchecked" : (nodes == reference ? "ok" : "MISMATCH");
+    if(hasReference && nodes != reference) allCorrect = false;
+
+    double minNps = nodesPerSecond.front();
+    double medianNps = nodesPerSecond[nodesPerSecond.size() / 2];
+    double maxNps = nodesPerSecond.back();
+    if(options.csv) {
+      printf("%s,%d,%d,%llu,%llu,%s,%d,%.0f,%.0f,%.0f\n", bp.name.c_str(), depth, options.threads, nodes, reference,
+          status, options.runs, minNps, medianNps, maxNps);
+    } else {
+      printf("%-16s %5d %12llu %10s %14.0f %14.0f %14.0f\n", bp.name.c_str(), depth, nodes, status, minNps, medianNps, maxNps);
+      if(hasReference && nodes != reference) {
+        printf("  expected %llu nodes\n", reference);
+      }
+    }
+  }
+  if(!anyPosition) {
+    printUsage(argv[0]);
+    return 2;
+  }
+  return allCorrect ? 0 : 1;
+}
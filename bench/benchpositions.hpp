@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Boards of the nichess_bench suite. The tests use the same positions, so the bench reference
+ * counts and the test expectations are about the same boards.
+ */
+
+// 84 useful legal actions, from legalactionstest
+inline const std::string LEGAL_ACTIONS_1 = "0|0-king-140,1-pawn-10,empty,empty,empty,empty,empty,empty,empty,0-pawn-210,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-70,empty,0-pawn-30,empty,empty,empty,0-warrior-80,empty,empty,empty,empty,empty,empty,empty,1-pawn-100,empty,empty,empty,1-king-200,";
+
+// 46 useful legal actions, from legalactionstest
+inline const std::string LEGAL_ACTIONS_2 = "0|0-king-200,empty,empty,empty,empty,empty,empty,0-assassin-110,empty,0-pawn-300,empty,0-warrior-500,0-mage-230,0-pawn-300,empty,empty,empty,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,1-mage-230,1-warrior-500,empty,1-pawn-300,1-pawn-300,1-assassin-110,empty,empty,empty,empty,empty,empty,1-king-200,";
+
+// mages next to groups of enemy pieces, most abilities hit several pieces
+inline const std::string MAGE_SPLASH_1 = "0|0-king-200,empty,empty,empty,empty,empty,empty,empty,empty,0-pawn-300,empty,empty,empty,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,0-mage-230,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,1-pawn-300,empty,empty,empty,empty,empty,1-pawn-300,1-warrior-500,1-mage-230,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-king-200,";
+
+// player 2 to move, mages next to groups of enemy pieces
+inline const std::string MAGE_SPLASH_2 = "1|empty,empty,empty,empty,0-king-120,empty,empty,empty,empty,empty,empty,empty,0-mage-60,empty,empty,empty,empty,empty,empty,empty,0-pawn-90,0-pawn-90,empty,empty,empty,empty,empty,empty,0-warrior-300,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,1-mage-230,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,1-assassin-40,empty,empty,empty,empty,1-king-170,empty,empty,empty,";
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "nichess.hpp"
+#include "bitboard.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace nichess {
+
+/*
+ * Dense action indices for policy heads.
+ * A move index numbers every (source, destination) pair that some piece can move between on an
+ * empty board, ordered by source and then destination, with move skip last. Ability indices
+ * number the ability pairs the same way. The index of an action is
+ * moveIndex * NUM_ABILITY_INDICES + abilityIndex, which makes it a bijection between actions
+ * and [0, NUM_ACTION_INDICES).
+ */
+
+// Squares a piece of any type can reach from srcIdx on an empty board
+constexpr uint64_t anyPieceTargets(int srcIdx, bool abilities) {
+  uint64_t retval = 0;
+  if(abilities) {
+    for(int table = 0; table < NO_ABILITIES; table++) {
+      retval |= abilityTable.masks[table][srcIdx];
+    }
+  } else {
+    for(int table = 0; table < NO_MOVES; table++) {
+      retval |= moveTable.masks[table][srcIdx];
+    }
+  }
+  return retval;
+}
+
+constexpr int countSquarePairs(bool abilities) {
+  int retval = 0;
+  for(int sq = 0; sq < NUM_SQUARES; sq++) {
+    for(uint64_t targets = anyPieceTargets(sq, abilities); targets != 0; targets &= targets - 1) {
+      retval++;
+    }
+  }
+  return retval;
+}
+
+constexpr int NUM_MOVE_PAIRS = countSquarePairs(false);
+constexpr int NUM_ABILITY_PAIRS = countSquarePairs(true);
+constexpr int MOVE_SKIP_INDEX = NUM_MOVE_PAIRS;
+constexpr int ABILITY_SKIP_INDEX = NUM_ABILITY_PAIRS;
+constexpr int NUM_MOVE_INDICES = NUM_MOVE_PAIRS + 1;
+constexpr int NUM_ABILITY_INDICES = NUM_ABILITY_PAIRS + 1;
+constexpr int NUM_ACTION_INDICES = NUM_MOVE_INDICES * NUM_ABILITY_INDICES;
+// 64 bit words in a mask with one bit per move index and per ability index
+constexpr int MOVE_MASK_WORDS = (NUM_MOVE_INDICES + 63) / 64;
+constexpr int ABILITY_MASK_WORDS = (NUM_ABILITY_INDICES + 63) / 64;
+
+constexpr int maxMovesFrom(PieceType pieceType) {
+  int retval = 0;
+  for(int sq = 0; sq < NUM_SQUARES; sq++) {
+    int n = 0;
+    for(uint64_t targets = moveTable.masks[pieceTypeToMoveTable[pieceType]][sq]; targets != 0; targets &= targets - 1) {
+      n++;
+    }
+    retval = n > retval ? n : retval;
+  }
+  return retval;
+}
+
+// Upper bound on the number of legal moves of a position, move skip included
+constexpr int countMaxLegalMoves() {
+  int retval = 0;
+  for(Player player: {PLAYER_1, PLAYER_2}) {
+    int n = 1;
+    for(int t = 0; t < PIECE_TYPES_PER_PLAYER; t++) {
+      PieceType pieceType = PieceType(firstPieceType(player) + t);
+      int numPieces = pieceType == pawnType(player) ? PAWNS_PER_PLAYER : 1;
+      n += numPieces * maxMovesFrom(pieceType);
+    }
+    retval = n > retval ? n : retval;
+  }
+  return retval;
+}
+
+constexpr int MAX_LEGAL_MOVES = countMaxLegalMoves();
+
+/*
+ * pairIndices[src][dst] is the index of the pair or -1, pairSquares[index] is src * 64 + dst.
+ */
+template<int NUM_PAIRS>
+struct SquarePairTable {
+  std::array<std::array<int16_t, NUM_SQUARES>, NUM_SQUARES> pairIndices;
+  std::array<uint16_t, NUM_PAIRS> pairSquares;
+};
+
+template<int NUM_PAIRS>
+constexpr SquarePairTable<NUM_PAIRS> generateSquarePairTable(bool abilities) {
+  SquarePairTable<NUM_PAIRS> retval{};
+  int next = 0;
+  for(int src = 0; src < NUM_SQUARES; src++) {
+    uint64_t targets = anyPieceTargets(src, abilities);
+    for(int dst = 0; dst < NUM_SQUARES; dst++) {
+      if((targets >> dst) & 1) {
+        retval.pairIndices[src][dst] = (int16_t) next;
+        retval.pairSquares[next] = (uint16_t) (src * NUM_SQUARES + dst);
+        next++;
+      } else {
+        retval.pairIndices[src][dst] = -1;
+      }
+    }
+  }
+  return retval;
+}
+
+inline constexpr SquarePairTable<NUM_MOVE_PAIRS> movePairTable = generateSquarePairTable<NUM_MOVE_PAIRS>(false);
+inline constexpr SquarePairTable<NUM_ABILITY_PAIRS> abilityPairTable = generateSquarePairTable<NUM_ABILITY_PAIRS>(true);
+
+/*
+ * -1 if no piece can move from moveSrcIdx to moveDstIdx.
+ */
+inline int moveIndex(int moveSrcIdx, int moveDstIdx) {
+  return moveSrcIdx == MOVE_SKIP ? MOVE_SKIP_INDEX : movePairTable.pairIndices[moveSrcIdx][moveDstIdx];
+}
+
+/*
+ * -1 if no piece can use an ability from abilitySrcIdx on abilityDstIdx.
+ */
+inline int abilityIndex(int abilitySrcIdx, int abilityDstIdx) {
+  return abilitySrcIdx == ABILITY_SKIP ? ABILITY_SKIP_INDEX : abilityPairTable.pairIndices[abilitySrcIdx][abilityDstIdx];
+}
+
+/*
+ * Index of a legal action, any action that a piece can play on an empty board has one.
+ */
+inline int actionIndex(const PlayerAction& pa) {
+  return moveIndex(pa.moveSrcIdx, pa.moveDstIdx) * NUM_ABILITY_INDICES + abilityIndex(pa.abilitySrcIdx, pa.abilityDstIdx);
+}
+
+inline PlayerAction indexToAction(int index) {
+  int move = index / NUM_ABILITY_INDICES;
+  int ability = index % NUM_ABILITY_INDICES;
+  PlayerAction retval = PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  if(move != MOVE_SKIP_INDEX) {
+    retval.moveSrcIdx = movePairTable.pairSquares[move] / NUM_SQUARES;
+    retval.moveDstIdx = movePairTable.pairSquares[move] % NUM_SQUARES;
+  }
+  if(ability != ABILITY_SKIP_INDEX) {
+    retval.abilitySrcIdx = abilityPairTable.pairSquares[ability] / NUM_SQUARES;
+    retval.abilityDstIdx = abilityPairTable.pairSquares[ability] % NUM_SQUARES;
+  }
+  return retval;
+}
+
+/*
+ * Useful legal actions of a position in factorised form, for a policy with a move head and an
+ * ability head. moves has the bit of every move index that starts a useful legal action, move
+ * skip included. Row k describes one of those moves: moveIndices[k] is its move index and
+ * abilities[k] has the bit of every ability index (ability skip included) that can follow it.
+ * Only the first numMoves rows are written, move skip is row 0. The action of (move index,
+ * ability index) has index moveIndex * NUM_ABILITY_INDICES + abilityIndex as in actionIndex.
+ */
+class ActionMask {
+  public:
+    uint64_t moves[MOVE_MASK_WORDS];
+    int numMoves;
+    int16_t moveIndices[MAX_LEGAL_MOVES];
+    uint64_t abilities[MAX_LEGAL_MOVES][ABILITY_MASK_WORDS];
+    bool contains(const PlayerAction& pa) const;
+    int numActions() const;
+};
+
+inline bool ActionMask::contains(const PlayerAction& pa) const {
+  int move = moveIndex(pa.moveSrcIdx, pa.moveDstIdx);
+  int ability = abilityIndex(pa.abilitySrcIdx, pa.abilityDstIdx);
+  if(move < 0 || ability < 0) return false;
+  for(int k = 0; k < numMoves; k++) {
+    if(moveIndices[k] == move) return (abilities[k][ability / 64] >> (ability % 64)) & 1;
+  }
+  return false;
+}
+
+inline int ActionMask::numActions() const {
+  int retval = 0;
+  for(int k = 0; k < numMoves; k++) {
+    for(int w = 0; w < ABILITY_MASK_WORDS; w++) {
+      retval += popCount(abilities[k][w]);
+    }
+  }
+  return retval;
+}
+
+} // namespace nichess
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "nichess.hpp"
+#include "actionindex.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace nichess {
+
+/*
+ * Many games stepped in lockstep, for reinforcement learning environments.
+ * Game state is stored as structure of arrays: for every piece slot (player * NUM_STARTING_PIECES
+ * + piece index) one array of squares and one of health points, indexed by game. Actions are
+ * applied by loading a game into a single scratch Game, so the batch owns no Game objects
+ * besides that one.
+ *
+ * Batched outputs go to caller buffers with one entry per game, legal action masks are one
+ * ActionMask per game (see actionindex.hpp) and only contain useful actions. Finished games
+ * ignore step and have empty masks.
+ */
+class GameBatch {
+  public:
+    GameBatch(GameCache& gameCache, int numGames);
+    int size() const;
+    // Starting position for every game with mask[i] != 0, or every game if mask is nullptr
+    void reset(const uint8_t* mask = nullptr);
+    void step(const PlayerAction* actions);
+    void gameOver(uint8_t* out) const;
+    // -1 while the game is running, otherwise the winning player
+    void winner(int8_t* out) const;
+    void currentPlayers(uint8_t* out) const;
+    void legalActionMasks(ActionMask* out);
+    // INPUT_PLANES_SIZE values per game, see planes.hpp
+    void encodePlanes(float* out, bool sideToMove = false) const;
+    void encodePlanes(int8_t* out, bool sideToMove = false) const;
+    void load(int gameIndex, Game& game) const;
+    void store(int gameIndex, const Game& game);
+
+  private:
+    int numGames;
+    Game scratch;
+    Game startingPosition;
+    std::vector<uint8_t> squares;
+    std::vector<int16_t> healthPoints;
+    std::vector<uint8_t> players;
+    std::vector<int32_t> moveNumbers;
+
+    bool isOver(int gameIndex) const;
+    template<typename T> void encodeAllPlanes(T* out, bool sideToMove) const;
+};
+
+} // namespace nichess
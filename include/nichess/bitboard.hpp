@@ -0,0 +1,127 @@
+#pragma once
+
+#include "nichess.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+
+namespace nichess {
+
+/*
+ * Index of the least significant set bit. bb must not be 0.
+ */
+inline int lsbIndex(uint64_t bb) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bb);
+#else
+  int idx = 0;
+  while((bb & 1) == 0) {
+    bb >>= 1;
+    idx++;
+  }
+  return idx;
+#endif
+}
+
+/*
+ * Number of set bits.
+ */
+inline int popCount(uint64_t bb) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(bb);
+#else
+  int count = 0;
+  while(bb != 0) {
+    bb &= bb - 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+/*
+ * Returns index of the least significant set bit and clears it. bb must not be 0.
+ */
+inline int popLsb(uint64_t& bb) {
+  int idx = lsbIndex(bb);
+  bb &= bb - 1;
+  return idx;
+}
+
+inline uint64_t squareMask(int squareIndex) {
+  return 1ULL << squareIndex;
+}
+
+/*
+ * Piece type of each piece slot, e.g. slotToPieceType[PLAYER_2][MAGE_PIECE_INDEX] == P2_MAGE
+ */
+constexpr PieceType slotToPieceType[NUM_PLAYERS][NUM_STARTING_PIECES] = {
+  {P1_MAGE, P1_ASSASSIN, P1_WARRIOR, P1_PAWN, P1_PAWN, P1_PAWN, P1_KING},
+  {P2_MAGE, P2_ASSASSIN, P2_WARRIOR, P2_PAWN, P2_PAWN, P2_PAWN, P2_KING}
+};
+
+/*
+ * Everything needed to revert an action on a BitboardGame.
+ * Affected and killed pieces are stored as bitmasks over the opponent's piece slots.
+ */
+class BitboardUndoInfo {
+  public:
+    int moveSrcIdx, moveDstIdx;
+    AbilityType abilityType;
+    uint8_t affectedSlots;
+    uint8_t killedSlots;
+    BitboardUndoInfo();
+};
+
+/*
+ * Alternative representation of the game state. Instead of a board of Piece pointers it keeps
+ * an occupancy bitboard per piece type and per player, and piece slot arrays with squares and
+ * health points. Slots use the same indices as Game::playerPiece (KING_PIECE_INDEX etc.).
+ * A dead piece keeps its last square but is removed from all bitboards.
+ *
+ * Game has since taken over the occupancy masks, so BitboardGame isn't used by the engine. It's
+ * kept as a second, independently written implementation of the rules: bitboardtest plays the
+ * same games on both and compares positions, action lists and perft counts, which catches
+ * generator bugs that a test against fixed counts only catches in the positions it covers.
+ */
+class BitboardGame {
+  public:
+    uint64_t pieceTypeToOccupancy[NUM_PIECE_TYPE - 1]; // NO_PIECE is not stored
+    uint64_t playerToOccupancy[NUM_PLAYERS];
+    int healthPoints[NUM_PLAYERS][NUM_STARTING_PIECES];
+    int pieceSquare[NUM_PLAYERS][NUM_STARTING_PIECES];
+    // slot of the living piece on each square, only meaningful where playerToOccupancy is set
+    uint8_t squareSlots[NUM_SQUARES];
+    Player currentPlayer;
+    int moveNumber;
+    GameCache *gameCache;
+
+    BitboardGame(GameCache &gameCache);
+    BitboardGame(GameCache &gameCache, const std::string encodedBoard);
+    void makeMove(int moveSrcIdx, int moveDstIdx);
+    void undoMove(int moveSrcIdx, int moveDstIdx);
+    BitboardUndoInfo makeAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx);
+    void undoAction(const BitboardUndoInfo& undoInfo);
+    std::vector<PlayerAction> usefulLegalActions();
+    std::vector<PlayerAction> allLegalActions();
+    int slotBySquareIndex(Player player, int squareIndex) const;
+    Piece getPieceBySquareIndex(int squareIndex) const;
+    std::string boardToString() const;
+    void boardFromString(std::string encodedBoard);
+    ParseError parseBoard(std::string_view encodedBoard);
+    bool gameOver() const;
+    std::optional<Player> winner() const;
+    void reset();
+
+  private:
+    void addPiece(Player player, int slot, int healthPoints, int squareIndex);
+    void removePiece(Player player, int slot);
+    uint64_t legalMovesMask(Player player, int slot, uint64_t occupied) const;
+};
+
+unsigned long long perft(BitboardGame& game, int depth);
+
+} // namespace nichess
@@ -1,3 +1,5 @@
+#pragma once
+
 namespace nichess {
 
 const int NUM_ROWS = 8;
@@ -19,9 +21,25 @@ const int PAWN_ABILITY_POINTS = 30;
 const int WARRIOR_ABILITY_POINTS = 100;
 const int ASSASSIN_ABILITY_POINTS = 120;
 
+// Piece values used by the evaluation, in health points. Kings have no value since losing
+// one ends the game.
+const int KING_VALUE = 0;
+const int MAGE_VALUE = 200;
+const int PAWN_VALUE = 50;
+const int WARRIOR_VALUE = 150;
+const int ASSASSIN_VALUE = 150;
+
 const int NUM_PLAYERS = 2;
 const int NUM_PIECE_TYPE = 11;
 
+// Upper bounds for any position:
+// moves of king, mage, warrior (8 each), assassin (28) and pawns (9 each)
+const int MAX_NUM_MOVES = 79;
+// abilities of mage (24) and the others (8 each), useful or not
+const int MAX_NUM_ABILITIES = 72;
+// every move with every ability or ability skip, then move skip with the same
+const int MAX_NUM_ACTIONS = (MAX_NUM_MOVES + 1) * (MAX_NUM_ABILITIES + 1);
+
 // piece index is not the same thing as board(square) index
 // it is used as an array index for faster access to a specific piece
 const int MAGE_PIECE_INDEX = 0;
@@ -31,5 +49,6 @@ const int PAWN_1_PIECE_INDEX = 3;
 const int PAWN_2_PIECE_INDEX = 4;
 const int PAWN_3_PIECE_INDEX = 5;
 const int KING_PIECE_INDEX = 6;
+const int PAWNS_PER_PLAYER = PAWN_3_PIECE_INDEX - PAWN_1_PIECE_INDEX + 1;
 
 } // namespace nichess
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "nichess.hpp"
+
+namespace nichess {
+
+// Bonus for each own piece next to the enemy king
+const int KING_ZONE_WEIGHT = 20;
+
+/*
+ * Static evaluation from the point of view of the player to move: health point and material
+ * balance plus king zone pressure. Reads only the accumulators kept by the game, so it's O(1).
+ */
+int evaluate(const Game& game);
+
+} // namespace nichess
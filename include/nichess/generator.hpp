@@ -0,0 +1,79 @@
+#pragma once
+
+#include "nichess.hpp"
+#include "actionindex.hpp"
+
+namespace nichess {
+
+/*
+ * Whether the living piece can move to moveDstIdx, which must be in its move table.
+ */
+bool isMoveLegal(const Game& game, const Piece* piece, int moveDstIdx);
+
+/*
+ * Writes the abilities of the piece, used from abilitySrcIdx, that hit an enemy of the current
+ * player and returns their number (at most NUM_STARTING_PIECES).
+ * abilitySrcIdx doesn't have to be the piece's square, which allows looking at abilities
+ * after a move without making it.
+ */
+int usefulAbilities(const Game& game, const Piece* piece, int abilitySrcIdx, PlayerAbility* out);
+
+/*
+ * Writes the useful legal actions into mask (see ActionMask in actionindex.hpp). Works on
+ * bitboards and pair indices directly, no PlayerAction is built. Clears the move bits and
+ * writes only the rows of the legal moves, so the cost follows the number of legal moves.
+ */
+void legalActionMask(const Game& game, ActionMask& mask);
+
+/*
+ * Lazily yields the same actions as Game::usefulLegalActions(), in stages:
+ *   ABILITIES              move skipped, every useful ability
+ *   MOVES_WITH_ABILITIES   for each piece and each of its legal moves, every useful ability
+ *                          that is available after the move
+ *   PLAIN_MOVES            every legal move with the ability skipped
+ *   SKIP                   both move and ability skipped
+ * stage() is the stage of the last action next() returned, DONE once next() has returned false.
+ * Abilities after a move are computed without touching the board: a move only empties a
+ * friendly square and fills another one, so every piece except the moving one keeps its
+ * targets, and the moving piece attacks from its destination.
+ *
+ * All state lives in the generator and nothing is computed before the first call to next(),
+ * so a generator can be abandoned at any point for free. The game must not change while
+ * the generator is in use.
+ */
+class ActionGenerator {
+  public:
+    enum Stage: int {
+      ABILITIES, MOVES_WITH_ABILITIES, PLAIN_MOVES, SKIP, DONE
+    };
+
+    ActionGenerator(const Game& game);
+    bool next(PlayerAction& action);
+    Stage stage() const;
+    void reset();
+
+  private:
+    // useful abilities can only target the enemy's pieces
+    static const int MAX_ABILITIES = NUM_STARTING_PIECES * NUM_STARTING_PIECES;
+
+    const Game* game;
+    Stage currentStage;
+    bool started;
+    // useful abilities of the current position and the slot of the piece using them
+    PlayerAbility abilities[MAX_ABILITIES];
+    int abilitySlots[MAX_ABILITIES];
+    int numAbilities;
+    int abilityIdx;
+    // current moving piece, its move and its abilities from the move destination
+    int pieceSlot;
+    int moveIdx;
+    PlayerMove currentMove;
+    PlayerAbility movedAbilities[NUM_STARTING_PIECES];
+    int numMovedAbilities;
+    int movedAbilityIdx;
+
+    void start();
+    bool nextMove(PlayerMove& move);
+};
+
+} // namespace nichess
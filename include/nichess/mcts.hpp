@@ -0,0 +1,138 @@
+#pragma once
+
+#include "nichess.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace nichess {
+
+enum SelectionPolicy: int {
+  UCT, PUCT
+};
+
+enum RolloutPolicy: int {
+  // uniformly random move (or move skip), then uniformly random useful ability (or ability skip)
+  RANDOM_ROLLOUT,
+  // like RANDOM_ROLLOUT, but the ability is only skipped if there is none
+  ABILITY_FIRST_ROLLOUT
+};
+
+/*
+ * Writes a prior probability for each action, in the same order. Only used with PUCT.
+ */
+typedef std::function<void(const Game& game, const ActionList& actions, float* priors)> PriorFunction;
+
+/*
+ * Budget is the number of playouts and/or seconds, 0 means no limit but one of them must be set
+ * (the Mcts constructor throws otherwise). maxNodes is at least 1, the root.
+ * Rollouts longer than maxRolloutPlies are scored by the health point balance.
+ * With numThreads > 1 the playouts are shared between threads that work on the same tree,
+ * 0 means one thread per core. Worker i uses seed + i.
+ */
+class MctsConfig {
+  public:
+    SelectionPolicy selectionPolicy;
+    double explorationConstant;
+    PriorFunction priorFunction; // uniform priors if empty
+    RolloutPolicy rolloutPolicy;
+    int maxRolloutPlies;
+    unsigned long long maxPlayouts;
+    double maxSeconds;
+    uint32_t maxNodes;
+    uint64_t seed;
+    int numThreads;
+    MctsConfig();
+};
+
+/*
+ * Tree node, 32 bytes. Children of a node are stored next to each other in the node pool.
+ * Value is the sum of playout results from the point of view of the player who played action.
+ *
+ * Statistics are atomic so that several threads can update them. Virtual losses count the
+ * playouts that are currently going through the node; selection treats them as lost.
+ * Children packs firstChild and numChildren so that a child block is published with a single
+ * store, it's 0 until the node is expanded.
+ */
+class MctsNode {
+  public:
+    int8_t moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx;
+    float prior;
+    std::atomic<uint64_t> children;
+    std::atomic<uint32_t> visits;
+    std::atomic<uint32_t> virtualLosses;
+    std::atomic<float> valueSum;
+    MctsNode();
+    void reset(const PlayerAction& pa, float prior);
+    PlayerAction action() const;
+    bool expanded() const;
+    uint32_t firstChild() const;
+    uint32_t numChildren() const;
+};
+
+class MctsWorker;
+
+/*
+ * Monte Carlo tree search over useful legal actions.
+ * Nodes live in a pool of config.maxNodes nodes allocated when Mcts is constructed; when the
+ * pool is full, leaves are no longer expanded but playouts continue. Playouts use make/undo on
+ * the searched game and pick random actions without generating the full action list, so
+ * a single threaded search doesn't allocate once the pool exists.
+ *
+ * With several threads, each extra thread plays on its own copy of the searched game and
+ * every playout starts at the root, making the actions of the selected path. A leaf is
+ * expanded by the thread that claims it with a compare-and-swap on its children, threads
+ * that lose the race roll out from the leaf instead of waiting.
+ *
+ * The tree is kept between searches. advance moves the root to the child of the action that
+ * was played and records the resulting position, and the rest of the tree goes back to the
+ * pool as free child blocks, one list per block size. Bigger blocks are split once the pool
+ * has no other free nodes. search continues from the kept tree, unless the searched position
+ * isn't the one the tree was built for. advance and clear must not run during a search.
+ */
+class Mcts {
+  public:
+    Mcts(const MctsConfig& config);
+    ~Mcts();
+    PlayerAction search(Game& game);
+    bool advance(const PlayerAction& pa, const Game& game);
+    void clear();
+    const MctsNode& root() const;
+    const MctsNode& node(uint32_t index) const;
+    uint32_t numNodes() const;
+    unsigned long long numPlayouts() const;
+
+  private:
+    MctsConfig config;
+    std::vector<MctsNode> nodes;
+    std::atomic<uint32_t> nextFreeNode;
+    // freeBlocks[n] is the first node of a free block of n nodes, its children holds the next block
+    std::vector<std::atomic<uint32_t>> freeBlocks;
+    std::atomic<uint32_t> numFreeNodes;
+    // hash of the root position, unknown after clear
+    uint64_t rootKey;
+    bool rootKeyKnown;
+    std::atomic<unsigned long long> playouts;
+    std::atomic<bool> stopped;
+    std::vector<std::unique_ptr<MctsWorker>> workers;
+
+    void work(MctsWorker& worker, Game& game, std::chrono::steady_clock::time_point deadline);
+    bool reservePlayout();
+    void playout(MctsWorker& worker, Game& game);
+    void descend(MctsWorker& worker, Game& game, uint32_t nodeIndex);
+    bool expand(MctsWorker& worker, Game& game, uint32_t nodeIndex);
+    bool allocateNodes(uint32_t count, uint32_t& first);
+    bool popFreeBlock(uint32_t count, uint32_t& first);
+    void pushFreeBlock(uint32_t first, uint32_t count);
+    void freeSubtree(uint32_t nodeIndex);
+    uint32_t selectChild(uint32_t nodeIndex) const;
+    float rollout(MctsWorker& worker, Game& game);
+    PlayerAction randomAction(MctsWorker& worker, const Game& game);
+    uint32_t bestChild() const;
+};
+
+} // namespace nichess
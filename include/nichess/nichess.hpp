@@ -1,10 +1,15 @@
 #pragma once 
 
 #include "constants.hpp"
+#include "tables.hpp"
 
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <tuple>
+#include <type_traits>
 
 namespace nichess {
 
@@ -31,9 +36,9 @@ class Piece {
     PieceType type;
     int healthPoints;
     int squareIndex;
-    Piece();
-    Piece(PieceType type, int healthPoints, int squareIndex);
-    Piece(const Piece& other);
+    constexpr Piece(): type(PieceType::NO_PIECE), healthPoints(0), squareIndex(0) { }
+    constexpr Piece(PieceType type, int healthPoints, int squareIndex):
+      type(type), healthPoints(healthPoints), squareIndex(squareIndex) { }
     bool operator==(const Piece& other) const;
     bool operator!=(const Piece& other) const;
 };
@@ -41,61 +46,322 @@ class Piece {
 class PlayerMove {
   public:
     int moveSrcIdx, moveDstIdx;
-    PlayerMove();
-    PlayerMove(int moveSrcIdx, int moveDstIdx);
+    PlayerMove() { }
+    constexpr PlayerMove(int moveSrcIdx, int moveDstIdx): moveSrcIdx(moveSrcIdx), moveDstIdx(moveDstIdx) { }
 };
 
 class PlayerAbility {
   public:
     int abilitySrcIdx, abilityDstIdx;
-    PlayerAbility();
-    PlayerAbility(int abilitySrcIdx, int abilityDstIdx);
+    PlayerAbility() { }
+    constexpr PlayerAbility(int abilitySrcIdx, int abilityDstIdx): abilitySrcIdx(abilitySrcIdx), abilityDstIdx(abilityDstIdx) { }
 };
 
 class PlayerAction {
   public:
     int moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx;
-    PlayerAction();
-    PlayerAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx);
+    PlayerAction() { }
+    constexpr PlayerAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx):
+      moveSrcIdx(moveSrcIdx), moveDstIdx(moveDstIdx), abilitySrcIdx(abilitySrcIdx), abilityDstIdx(abilityDstIdx) { }
 };
 
+/*
+ * Fixed-capacity list of actions, big enough for all legal actions of any position.
+ * It never allocates, so it can live on the stack or be reused across calls.
+ */
+class ActionList {
+  public:
+    ActionList(): numActions(0) { }
+    void push_back(const PlayerAction& action) { actions[numActions++] = action; }
+    void clear() { numActions = 0; }
+    int size() const { return numActions; }
+    bool empty() const { return numActions == 0; }
+    PlayerAction& operator[](int i) { return actions[i]; }
+    const PlayerAction& operator[](int i) const { return actions[i]; }
+    PlayerAction* begin() { return actions; }
+    PlayerAction* end() { return actions + numActions; }
+    const PlayerAction* begin() const { return actions; }
+    const PlayerAction* end() const { return actions + numActions; }
+
+  private:
+    PlayerAction actions[MAX_NUM_ACTIONS];
+    int numActions;
+};
+
+/*
+ * One ActionList per ply, allocated once up front, for recursive code like perft and search.
+ */
+class ActionStack {
+  public:
+    ActionStack(int maxPly);
+    ActionList& at(int ply);
+    int maxPly() const;
+
+  private:
+    std::vector<ActionList> lists;
+};
+
+// Longest boardToString output: player, '|' and 64 squares like "1-assassin-110,"
+const int MAX_BOARD_STRING_LENGTH = 2 + NUM_SQUARES * 16;
+
+enum ParseError: int {
+  PARSE_OK, PARSE_BAD_PLAYER, PARSE_BAD_TOKEN, PARSE_BAD_HEALTH_POINTS, PARSE_TOO_MANY_PIECES, PARSE_BAD_SQUARE_COUNT
+};
+
+const char* parseErrorToString(ParseError error);
+
+/*
+ * Parses the text encoding into the player to move and the pieces by slot, dead pieces have 0
+ * health points. Shared by Game and BitboardGame. The outputs are only meaningful on PARSE_OK.
+ */
+ParseError parseBoardPieces(std::string_view encodedBoard, Player& currentPlayer, Piece pieces[NUM_PLAYERS][NUM_STARTING_PIECES]);
+
+/*
+ * Fixed-size binary position, 32 bytes:
+ *   byte 0      player to move
+ *   byte 1      reserved, always 0
+ *   bytes 2-3   move number, capped at 65535
+ *   bytes 4-31  one little endian 16 bit word per piece slot (player * NUM_STARTING_PIECES +
+ *               piece index): square index in bits 0-5, health points in bits 6-15, 0 if dead
+ * Piece types follow from the slots, and dead pieces keep their last square.
+ */
+const int POSITION_RECORD_SIZE = 32;
+
+class PositionRecord {
+  public:
+    uint8_t bytes[POSITION_RECORD_SIZE];
+};
+
+/*
+ * Everything needed to revert an action, 5 bytes. Damaged pieces are a bitmask over the piece
+ * slots of the player who didn't act, each lost abilityTypeToAbilityPoints[abilityType] health
+ * points and the killed ones go back on the board. Nothing points into the Game, so an
+ * UndoInfo can be stored anywhere and also reverts the action on a copy of the game.
+ */
 class UndoInfo {
   public:
-    Piece* affectedPieces[9];
-    int moveSrcIdx, moveDstIdx;
-    AbilityType abilityType;
+    int8_t moveSrcIdx, moveDstIdx;
+    uint8_t abilityType; // AbilityType
+    uint8_t affectedSlots;
+    uint8_t killedSlots;
     UndoInfo();
     UndoInfo(int moveSrcIdx, int moveDstIdx, AbilityType abilityType);
 };
 
+// GameHistory keeps the undo information of this many of the last actions
+const int UNDO_HISTORY_LENGTH = 128;
+static_assert((UNDO_HISTORY_LENGTH & (UNDO_HISTORY_LENGTH - 1)) == 0, "ring buffer length must be a power of 2");
+
+constexpr MoveTable pieceTypeToMoveTable[NUM_PIECE_TYPE] = {
+  ONE_SQUARE_MOVES, ONE_SQUARE_MOVES, ONE_SQUARE_MOVES, ASSASSIN_MOVES, P1_PAWN_MOVES,
+  ONE_SQUARE_MOVES, ONE_SQUARE_MOVES, ONE_SQUARE_MOVES, ASSASSIN_MOVES, P2_PAWN_MOVES,
+  NO_MOVES
+};
+
+constexpr AbilityTable pieceTypeToAbilityTable[NUM_PIECE_TYPE] = {
+  ONE_SQUARE_ABILITIES, MAGE_ABILITIES, ONE_SQUARE_ABILITIES, ONE_SQUARE_ABILITIES, ONE_SQUARE_ABILITIES,
+  ONE_SQUARE_ABILITIES, MAGE_ABILITIES, ONE_SQUARE_ABILITIES, ONE_SQUARE_ABILITIES, ONE_SQUARE_ABILITIES,
+  NO_ABILITIES
+};
+
+constexpr int abilityTypeToAbilityPoints[NO_ABILITY + 1] = {
+  KING_ABILITY_POINTS, MAGE_ABILITY_POINTS, WARRIOR_ABILITY_POINTS, ASSASSIN_ABILITY_POINTS,
+  PAWN_ABILITY_POINTS, 0
+};
+
+constexpr AbilityType pieceTypeToAbilityType[NUM_PIECE_TYPE] = {
+  KING_DAMAGE, MAGE_DAMAGE, WARRIOR_DAMAGE, ASSASSIN_DAMAGE, PAWN_DAMAGE,
+  KING_DAMAGE, MAGE_DAMAGE, WARRIOR_DAMAGE, ASSASSIN_DAMAGE, PAWN_DAMAGE,
+  NO_ABILITY
+};
+
+// Each player has this many piece types, player's types are a range starting at its king
+constexpr int PIECE_TYPES_PER_PLAYER = P2_KING - P1_KING;
+
+constexpr PieceType firstPieceType(Player player) {
+  return player == PLAYER_1 ? P1_KING : P2_KING;
+}
+
+constexpr PieceType pawnType(Player player) {
+  return player == PLAYER_1 ? P1_PAWN : P2_PAWN;
+}
+
+// Square offset of one step forward for the player's pawns
+constexpr int pawnForward(Player player) {
+  return player == PLAYER_1 ? NUM_COLUMNS : -NUM_COLUMNS;
+}
+
+/*
+ * Single comparison instead of a switch over the piece types, NO_PIECE belongs to nobody.
+ */
+template<Player P>
+constexpr bool isPieceOf(PieceType pieceType) {
+  return (unsigned) (pieceType - firstPieceType(P)) < (unsigned) PIECE_TYPES_PER_PLAYER;
+}
+
+/*
+ * What an ability of the attacker type does to a piece of the target type, one indexed load
+ * instead of switches over both types. Only abilities that hit an enemy piece are useful, the
+ * others change nothing and have abilityType NO_ABILITY and no damage.
+ */
+struct AbilityEffect {
+  bool useful;
+  // the target's enemy neighbours take the same damage
+  bool splash;
+  uint8_t abilityType; // AbilityType
+  uint8_t damage;
+};
+
+struct AbilityEffectTable {
+  AbilityEffect effects[NUM_PIECE_TYPE][NUM_PIECE_TYPE];
+};
+
+constexpr AbilityEffectTable generateAbilityEffectTable() {
+  AbilityEffectTable table{};
+  for(int attacker = 0; attacker < NUM_PIECE_TYPE; attacker++) {
+    for(int target = 0; target < NUM_PIECE_TYPE; target++) {
+      bool useful = (isPieceOf<PLAYER_1>(PieceType(attacker)) && isPieceOf<PLAYER_2>(PieceType(target))) ||
+        (isPieceOf<PLAYER_2>(PieceType(attacker)) && isPieceOf<PLAYER_1>(PieceType(target)));
+      AbilityType abilityType = useful ? pieceTypeToAbilityType[attacker] : NO_ABILITY;
+      table.effects[attacker][target] = {useful, abilityType == MAGE_DAMAGE, (uint8_t) abilityType,
+        (uint8_t) abilityTypeToAbilityPoints[abilityType]};
+    }
+  }
+  return table;
+}
+
+inline constexpr AbilityEffectTable abilityEffectTable = generateAbilityEffectTable();
+static_assert(ASSASSIN_ABILITY_POINTS <= UINT8_MAX, "damage must fit in AbilityEffect");
+
+// Text tokens of the piece types in the board encoding, followed by the health points
+inline constexpr std::string_view pieceTypeTokens[NUM_PIECE_TYPE] = {
+  "0-king-", "0-mage-", "0-warrior-", "0-assassin-", "0-pawn-",
+  "1-king-", "1-mage-", "1-warrior-", "1-assassin-", "1-pawn-",
+  "empty"
+};
+
+constexpr int pieceTypeToValue[NUM_PIECE_TYPE] = {
+  KING_VALUE, MAGE_VALUE, WARRIOR_VALUE, ASSASSIN_VALUE, PAWN_VALUE,
+  KING_VALUE, MAGE_VALUE, WARRIOR_VALUE, ASSASSIN_VALUE, PAWN_VALUE,
+  0
+};
+
+/*
+ * Per player sums over the living pieces, kept up to date by makeAction/undoAction so that
+ * the evaluation doesn't have to walk the pieces.
+ */
+class Accumulators {
+  public:
+    int healthPoints[NUM_PLAYERS];
+    // sum of pieceTypeToValue
+    int material[NUM_PLAYERS];
+    // enemy pieces on the squares next to the player's king
+    int kingZonePieces[NUM_PLAYERS];
+    bool operator==(const Accumulators& other) const;
+    bool operator!=(const Accumulators& other) const;
+};
+
 /*
  * Used for faster generation and validation of actions.
+ * All tables are generated at compile time (see tables.hpp), so constructing a GameCache is free
+ * and lookups never allocate.
  */
 class GameCache {
   public:
-    std::vector<std::vector<std::vector<PlayerMove>>> pieceTypeToSquareIndexToLegalMoves;
-    std::vector<std::vector<std::vector<PlayerAbility>>> pieceTypeToSquareIndexToLegalAbilities;
-    std::vector<std::vector<int>> squareToNeighboringSquares;
-    
-    GameCache(); 
+    // Legal moves and abilities as if there were no other pieces on the board
+    SquareList<PlayerMove> legalMoves(PieceType pieceType, int squareIndex) const {
+      const uint16_t* offsets = &moveTable.offsets[pieceTypeToMoveTable[pieceType]][squareIndex];
+      return SquareList<PlayerMove>(squareIndex, moveTable.squares.data() + offsets[0], moveTable.squares.data() + offsets[1]);
+    }
+    SquareList<PlayerAbility> legalAbilities(PieceType pieceType, int squareIndex) const {
+      const uint16_t* offsets = &abilityTable.offsets[pieceTypeToAbilityTable[pieceType]][squareIndex];
+      return SquareList<PlayerAbility>(squareIndex, abilityTable.squares.data() + offsets[0], abilityTable.squares.data() + offsets[1]);
+    }
+    // Squares that are touching the given square, used for mage ability
+    SquareList<int> neighboringSquares(int squareIndex) const {
+      const uint16_t* offsets = &abilityTable.offsets[ONE_SQUARE_ABILITIES][squareIndex];
+      return SquareList<int>(squareIndex, abilityTable.squares.data() + offsets[0], abilityTable.squares.data() + offsets[1]);
+    }
+    // Same tables as bitboards, bit i is set if square i is in the list
+    uint64_t legalMovesMask(PieceType pieceType, int squareIndex) const {
+      return moveTable.masks[pieceTypeToMoveTable[pieceType]][squareIndex];
+    }
+    uint64_t legalAbilitiesMask(PieceType pieceType, int squareIndex) const {
+      return abilityTable.masks[pieceTypeToAbilityTable[pieceType]][squareIndex];
+    }
+    uint64_t neighboringSquaresMask(int squareIndex) const {
+      return abilityTable.masks[ONE_SQUARE_ABILITIES][squareIndex];
+    }
 };
 
+class GameBatch;
+
+/*
+ * The state has no pointers into itself (squares refer to piece slots by index), so Game is
+ * trivially copyable and a copy is a plain memcpy of 384 bytes. No undo history is stored in
+ * the Game, callers that want one keep a GameHistory next to it.
+ */
 class Game {
+  friend class GameBatch;
   private:
+    // Pieces stay in their slot for the whole lifetime of the Game, dead pieces included.
+    // The first piece of the extra row is the NO_PIECE of all empty squares (EMPTY_SLOT), it's
+    // never modified.
+    Piece pieces[NUM_PLAYERS + 1][NUM_STARTING_PIECES];
+    // slot (player * NUM_STARTING_PIECES + piece index) of the living piece on each square
+    uint8_t squareSlots[NUM_SQUARES];
+    uint64_t zobristKey;
+    Accumulators accumulatorValues;
+    // squares of the living pieces of each player
+    uint64_t occupancy[NUM_PLAYERS];
     Game();
+    void placePieces();
+    void relocatePiece(Piece* piece, int srcIdx, int dstIdx);
+    void damagePiece(Piece* piece, int abilityPoints, UndoInfo& undoInfo);
+    void restorePiece(Piece* piece, int abilityPoints, bool killed);
+    // Specialised on the player who acts, the public functions dispatch on currentPlayer once
+    template<Player Us> UndoInfo makeActionFor(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx);
+    template<Player Us> void undoActionFor(const UndoInfo& undoInfo);
+    template<Player Us> bool pawnJumpBlocked(const Piece& piece, int moveDstIdx) const;
+    template<Player Us> bool isActionLegalFor(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx);
+    template<Player Us> std::vector<PlayerMove> legalMovesByPieceFor(int srcSquareIdx);
+    template<Player Us> std::vector<PlayerAbility> usefulLegalAbilitiesByPieceFor(int srcSquareIdx);
+    template<Player Us> std::vector<PlayerAbility> allLegalAbilitiesByPieceFor(int srcSquareIdx);
+    template<Player Us> void abilitySources(uint64_t* sources) const;
+    template<Player Us, typename ActionContainer>
+    void pushUsefulAbilities(int moveSrcIdx, int moveDstIdx, const uint64_t* sources, ActionContainer& retval) const;
+    template<Player Us, typename ActionContainer> void generateUsefulLegalActionsFor(ActionContainer& retval);
+    template<typename ActionContainer> void generateUsefulLegalActions(ActionContainer& retval);
+    template<Player Us, typename ActionContainer>
+    void pushAllAbilities(int moveSrcIdx, int moveDstIdx, ActionContainer& retval) const;
+    template<Player Us, typename ActionContainer> void generateAllLegalActionsFor(ActionContainer& retval);
+    template<typename ActionContainer> void generateAllLegalActions(ActionContainer& retval);
   public:
-    Piece* board[NUM_SQUARES];
-    Piece* p1King;
-    Piece* p2King;
-    std::vector<std::vector<Piece*>> playerToPieces{NUM_PLAYERS};
     Player currentPlayer;
     int moveNumber;
     GameCache *gameCache;
 
     Game(GameCache &gameCache);
-    Game(const Game& other);
     Game(GameCache &gameCache, const std::string encodedBoard);
-    ~Game();
+    static const int EMPTY_SLOT = NUM_PLAYERS * NUM_STARTING_PIECES;
+
+    // Piece on the square, a NO_PIECE if there is no living piece (its squareIndex is meaningless)
+    Piece* pieceAt(int squareIndex) {
+      return &pieces[0][0] + squareSlots[squareIndex];
+    }
+    const Piece* pieceAt(int squareIndex) const {
+      return &pieces[0][0] + squareSlots[squareIndex];
+    }
+    bool isSquareEmpty(int squareIndex) const {
+      return squareSlots[squareIndex] == EMPTY_SLOT;
+    }
+    // Piece in the slot, also when it's dead
+    Piece* playerPiece(Player player, int pieceIndex) {
+      return &pieces[player][pieceIndex];
+    }
+    const Piece* playerPiece(Player player, int pieceIndex) const {
+      return &pieces[player][pieceIndex];
+    }
     void makeMove(int moveSrcIdx, int moveDstIdx);
     void undoMove(int moveSrcIdx, int moveDstIdx);
     bool isActionLegal(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx);
@@ -103,6 +369,8 @@ class Game {
     void undoAction(UndoInfo undoInfo);
     std::vector<PlayerAction> usefulLegalActions();
     std::vector<PlayerAction> allLegalActions();
+    void usefulLegalActions(ActionList& actions);
+    void allLegalActions(ActionList& actions);
     std::vector<PlayerMove> legalMovesByPiece(int srcSquareIdx);
     std::vector<PlayerAbility> usefulLegalAbilitiesByPiece(int srcSquareIdx);
     std::vector<PlayerAbility> allLegalAbilitiesByPiece(int srcSquareIdx);
@@ -111,11 +379,44 @@ class Game {
     Piece getPieceBySquareIndex(int squareIndex);
     std::vector<Piece*> getAllPiecesByPlayer(Player player);
     std::string boardToString();
+    void appendBoard(std::string& out) const;
     void boardFromString(std::string encodedBoard);
+    ParseError parseBoard(std::string_view encodedBoard);
+    void encode(PositionRecord& record) const;
+    bool decode(const PositionRecord& record);
     bool gameOver();
     std::optional<Player> winner();
     std::string dump() const;
     void reset();
+    uint64_t hash() const;
+    uint64_t computeHash() const;
+    const Accumulators& accumulators() const;
+    Accumulators computeAccumulators() const;
+    uint64_t playerOccupancy(Player player) const;
+};
+
+static_assert(std::is_trivially_copyable<Game>::value, "Game must be copyable with memcpy");
+
+/*
+ * Undo history of a Game, kept by the caller so that copies of the Game don't carry it.
+ * Records the actions made through makeAction, undo reverts the last one. Only the last
+ * UNDO_HISTORY_LENGTH actions are kept. Game::makeAction/undoAction don't touch the history,
+ * so a search in between leaves it valid as long as the search restores the game.
+ * Clear it when the position of the game is set from scratch (reset, boardFromString, decode).
+ */
+class GameHistory {
+  public:
+    GameHistory();
+    UndoInfo makeAction(Game& game, int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx);
+    bool undo(Game& game);
+    int length() const;
+    void clear();
+
+  private:
+    // ring buffer, end is the index after the last action
+    UndoInfo actions[UNDO_HISTORY_LENGTH];
+    int end;
+    int size;
 };
 
 int coordinatesToBoardIndex(int column, int row);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "nichess.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nichess {
+
+/*
+ * Result of a perft run together with transposition table statistics.
+ * Probes are only made at depth >= 2, depth 1 is counted directly.
+ */
+class PerftResult {
+  public:
+    unsigned long long nodes;
+    unsigned long long probes;
+    unsigned long long hits;
+    PerftResult();
+    double hitRate() const;
+};
+
+/*
+ * Same count as perft(game, depth), but node counts of already visited (position, depth)
+ * pairs are looked up in a transposition table of at most ttBytes bytes, keyed by Game::hash().
+ * The table is allocated once per call. Game is left in its original state.
+ */
+PerftResult perftHashed(Game& game, int depth, size_t ttBytes);
+
+/*
+ * Same count as perft(game, depth), computed by numThreads workers (0 means
+ * std::thread::hardware_concurrency()). Every worker owns a copy of game and replays the
+ * actions leading to a subtree before counting it. Work is split at the root, and deeper
+ * (down to minSplitDepth remaining plies) whenever some worker is idle. Split subtrees go to
+ * the splitting worker's deque, idle workers steal from the other end.
+ */
+unsigned long long perftParallel(const Game& game, int depth, int numThreads, int minSplitDepth = 3);
+
+} // namespace nichess
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "nichess.hpp"
+
+#include <cstdint>
+
+namespace nichess {
+
+/*
+ * Neural network input planes, stored plane by plane (plane * NUM_SQUARES + square):
+ *   planes 0-9  one-hot piece planes in PieceType order
+ *   plane 10    health points of the piece on the square divided by HEALTH_POINTS_SCALE
+ *   plane 11    1 everywhere if PLAYER_2 is to move
+ * With sideToMove set and PLAYER_2 to move, rows are mirrored and the piece planes of the two
+ * players are swapped, so the player to move always sees its own pieces in planes 0-4 moving up
+ * the board. int8 planes use INT8_PLANE_ONE for 1.
+ */
+const int NUM_PIECE_PLANES = 10;
+const int HEALTH_POINTS_PLANE = 10;
+const int PLAYER_PLANE = 11;
+const int NUM_INPUT_PLANES = 12;
+const int INPUT_PLANES_SIZE = NUM_INPUT_PLANES * NUM_SQUARES;
+const int HEALTH_POINTS_SCALE = WARRIOR_STARTING_HEALTH_POINTS;
+const int INT8_PLANE_ONE = 127;
+
+// Write INPUT_PLANES_SIZE values per game, batched versions write the games one after another
+void encodePlanes(const Game& game, float* out, bool sideToMove = false);
+void encodePlanes(const Game& game, int8_t* out, bool sideToMove = false);
+void encodePlanes(const Game* games, int numGames, float* out, bool sideToMove = false);
+void encodePlanes(const Game* games, int numGames, int8_t* out, bool sideToMove = false);
+
+/*
+ * Planes of one position given as piece slots (player * NUM_STARTING_PIECES + piece index),
+ * used by the Game and GameBatch encoders.
+ */
+template<typename T>
+void encodePlanes(const PieceType* types, const int* squareIndices, const int* healthPoints, Player currentPlayer,
+    bool sideToMove, T* out);
+
+} // namespace nichess
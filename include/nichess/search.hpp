@@ -0,0 +1,71 @@
+#pragma once
+
+#include "nichess.hpp"
+
+#include <chrono>
+#include <vector>
+
+namespace nichess {
+
+// Score of a won position, reduced by the number of plies it takes to get there.
+const int WIN_SCORE = 1000000;
+const int MAX_SEARCH_PLY = 32;
+
+/*
+ * Limits for Search::search. 0 means no limit. Depth is capped at MAX_SEARCH_PLY and the first
+ * iteration (depth 1) always completes.
+ */
+class SearchLimits {
+  public:
+    int maxDepth;
+    unsigned long long maxNodes;
+    double maxSeconds;
+    SearchLimits();
+};
+
+/*
+ * Result of the deepest completed iteration. Score is from the point of view of the player
+ * to move. PV is empty if the game is already over.
+ */
+class SearchResult {
+  public:
+    PlayerAction bestAction;
+    int score;
+    int depth;
+    unsigned long long nodes;
+    std::vector<PlayerAction> pv;
+    SearchResult();
+};
+
+/*
+ * Negamax alpha-beta with iterative deepening, principal variation search and aspiration
+ * windows. Actions come from Game::usefulLegalActions, ordered with the previous PV action
+ * first and then actions that use an ability. Leaves are scored by evaluate. The game is modified during the search with
+ * makeAction/undoAction and restored before search returns.
+ *
+ * All per-ply buffers are allocated when Search is constructed, so one Search object
+ * should be reused across calls.
+ */
+class Search {
+  public:
+    Search();
+    SearchResult search(Game& game, const SearchLimits& limits);
+
+  private:
+    ActionStack actionStack;
+    PlayerAction pvTable[MAX_SEARCH_PLY + 1][MAX_SEARCH_PLY + 1];
+    int pvLength[MAX_SEARCH_PLY + 1];
+    std::vector<PlayerAction> previousPv;
+    unsigned long long nodes;
+    unsigned long long maxNodes;
+    unsigned long long nextTimeCheck;
+    bool timeLimited;
+    std::chrono::steady_clock::time_point deadline;
+    bool stopped;
+
+    int negamax(Game& game, int depth, int alpha, int beta, int ply);
+    void orderActions(ActionList& actions, int ply) const;
+    bool outOfBudget();
+};
+
+} // namespace nichess
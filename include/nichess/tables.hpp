@@ -0,0 +1,260 @@
+#pragma once
+
+#include "constants.hpp"
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace nichess {
+
+/*
+ * Lookup tables for moves, abilities and neighbouring squares on an empty board.
+ * They are generated at compile time and stored as one contiguous pool of destination squares
+ * per table kind: row (table, square) is pool[offsets[table][square] .. offsets[table][square + 1]).
+ * Every row is also available as a bitboard (bit i is set if square i is in the row).
+ *
+ * Player 1 and player 2 share a table whenever the pieces move or attack the same way,
+ * only pawn moves depend on the player.
+ */
+
+enum MoveTable: int {
+  ONE_SQUARE_MOVES, // king, mage, warrior
+  ASSASSIN_MOVES,
+  P1_PAWN_MOVES,
+  P2_PAWN_MOVES,
+  NO_MOVES,
+  NUM_MOVE_TABLES
+};
+
+enum AbilityTable: int {
+  ONE_SQUARE_ABILITIES, // king, warrior, assassin, pawn
+  MAGE_ABILITIES,
+  NO_ABILITIES,
+  NUM_ABILITY_TABLES
+};
+
+template<int NUM_TABLES, int POOL_SIZE>
+struct SquareTable {
+  std::array<std::array<uint16_t, NUM_SQUARES + 1>, NUM_TABLES> offsets;
+  std::array<uint8_t, POOL_SIZE> squares;
+  std::array<std::array<uint64_t, NUM_SQUARES>, NUM_TABLES> masks;
+};
+
+// Targets are all squares within this many rows and columns, plus special moves
+constexpr int squareRange(int table, bool abilities) {
+  if(abilities) {
+    return table == MAGE_ABILITIES ? 2 : (table == NO_ABILITIES ? 0 : 1);
+  }
+  return table == ASSASSIN_MOVES ? 2 : (table == NO_MOVES ? 0 : 1);
+}
+
+constexpr int NUM_SPECIAL_MOVES = 4;
+
+// Special moves as (dx, dy) pairs, (0, 0) means none.
+constexpr int specialMoveOffset(int table, int i, int coordinate) {
+  if(table == P1_PAWN_MOVES) {
+    // pawn can also go 2 squares forward
+    return i == 0 && coordinate == 1 ? 2 : 0;
+  }
+  if(table == P2_PAWN_MOVES) {
+    // for p2 forward means -2 on y axis
+    return i == 0 && coordinate == 1 ? -2 : 0;
+  }
+  if(table == ASSASSIN_MOVES) {
+    // 4 extra moves: (3, 3), (3, -3), (-3, 3), (-3, -3)
+    const int offsets[NUM_SPECIAL_MOVES][2] = {{3, 3}, {3, -3}, {-3, 3}, {-3, -3}};
+    return offsets[i][coordinate];
+  }
+  return 0;
+}
+
+constexpr bool isOnBoard(int x, int y) {
+  return x >= 0 && x < NUM_COLUMNS && y >= 0 && y < NUM_ROWS;
+}
+
+/*
+ * Calls visit(dstIdx) for every destination of the given table on an empty board.
+ * First the squares around the piece (dx outer, dy inner), then the special moves.
+ */
+template<typename Visitor>
+constexpr void forEachTarget(int table, bool abilities, int srcIdx, Visitor& visit) {
+  int x = srcIdx % NUM_COLUMNS;
+  int y = srcIdx / NUM_COLUMNS;
+  int range = squareRange(table, abilities);
+  for(int dx = -range; dx <= range; dx++) {
+    for(int dy = -range; dy <= range; dy++) {
+      if(dx == 0 && dy == 0) continue;
+      if(!isOnBoard(x + dx, y + dy)) continue;
+      visit(x + dx + (y + dy) * NUM_COLUMNS);
+    }
+  }
+  if(abilities) return;
+  for(int i = 0; i < NUM_SPECIAL_MOVES; i++) {
+    int dx = specialMoveOffset(table, i, 0);
+    int dy = specialMoveOffset(table, i, 1);
+    if(dx == 0 && dy == 0) continue;
+    if(!isOnBoard(x + dx, y + dy)) continue;
+    visit(x + dx + (y + dy) * NUM_COLUMNS);
+  }
+}
+
+struct TargetCounter {
+  int count = 0;
+  constexpr void operator()(int) { count++; }
+};
+
+constexpr int tablePoolSize(int numTables, bool abilities) {
+  TargetCounter counter;
+  for(int table = 0; table < numTables; table++) {
+    for(int sq = 0; sq < NUM_SQUARES; sq++) {
+      forEachTarget(table, abilities, sq, counter);
+    }
+  }
+  return counter.count;
+}
+
+template<int NUM_TABLES, int POOL_SIZE>
+struct TableWriter {
+  SquareTable<NUM_TABLES, POOL_SIZE>* out;
+  int table;
+  int srcIdx;
+  int next;
+  constexpr void operator()(int dstIdx) {
+    out->squares[next++] = (uint8_t) dstIdx;
+    out->masks[table][srcIdx] |= 1ULL << dstIdx;
+  }
+};
+
+template<int NUM_TABLES, int POOL_SIZE>
+constexpr SquareTable<NUM_TABLES, POOL_SIZE> generateSquareTable(bool abilities) {
+  SquareTable<NUM_TABLES, POOL_SIZE> retval{};
+  TableWriter<NUM_TABLES, POOL_SIZE> writer{&retval, 0, 0, 0};
+  for(int table = 0; table < NUM_TABLES; table++) {
+    for(int sq = 0; sq < NUM_SQUARES; sq++) {
+      retval.offsets[table][sq] = (uint16_t) writer.next;
+      writer.table = table;
+      writer.srcIdx = sq;
+      forEachTarget(table, abilities, sq, writer);
+    }
+    retval.offsets[table][NUM_SQUARES] = (uint16_t) writer.next;
+  }
+  return retval;
+}
+
+constexpr int MOVE_POOL_SIZE = tablePoolSize(NUM_MOVE_TABLES, false);
+constexpr int ABILITY_POOL_SIZE = tablePoolSize(NUM_ABILITY_TABLES, true);
+
+inline constexpr SquareTable<NUM_MOVE_TABLES, MOVE_POOL_SIZE> moveTable =
+  generateSquareTable<NUM_MOVE_TABLES, MOVE_POOL_SIZE>(false);
+inline constexpr SquareTable<NUM_ABILITY_TABLES, ABILITY_POOL_SIZE> abilityTable =
+  generateSquareTable<NUM_ABILITY_TABLES, ABILITY_POOL_SIZE>(true);
+
+// Ability tables of pieces that have abilities
+constexpr int NUM_ABILITY_SOURCES = NO_ABILITIES;
+
+/*
+ * Reverse ability tables: masks[table][dstIdx] has the squares from which a piece using the
+ * table reaches dstIdx. Useful abilities only hit enemy pieces, so generation can start from
+ * the few enemy squares instead of every square a piece reaches.
+ */
+struct ReverseAbilityTable {
+  std::array<std::array<uint64_t, NUM_SQUARES>, NUM_ABILITY_SOURCES> masks;
+};
+
+constexpr ReverseAbilityTable generateReverseAbilityTable() {
+  ReverseAbilityTable retval{};
+  for(int table = 0; table < NUM_ABILITY_SOURCES; table++) {
+    for(int src = 0; src < NUM_SQUARES; src++) {
+      for(int dst = 0; dst < NUM_SQUARES; dst++) {
+        if((abilityTable.masks[table][src] >> dst) & 1) {
+          retval.masks[table][dst] |= 1ULL << src;
+        }
+      }
+    }
+  }
+  return retval;
+}
+
+inline constexpr ReverseAbilityTable reverseAbilityTable = generateReverseAbilityTable();
+
+/*
+ * Zobrist keys. A position's hash is the XOR of pieceSquare[type][square] and the health points
+ * key of every living piece, plus side if PLAYER_2 is to move.
+ * Health points are keyed per piece slot (player * NUM_STARTING_PIECES + piece index) because
+ * they are not bounded by a small range: the key for a value is derived from the slot's seed.
+ */
+constexpr uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+struct ZobristKeys {
+  std::array<std::array<uint64_t, NUM_SQUARES>, NUM_PIECE_TYPE> pieceSquare;
+  std::array<uint64_t, NUM_PLAYERS * NUM_STARTING_PIECES> healthPointsSeed;
+  uint64_t side;
+};
+
+constexpr ZobristKeys generateZobristKeys() {
+  ZobristKeys retval{};
+  uint64_t state = 0x6e69636865737321ULL;
+  for(int pt = 0; pt < NUM_PIECE_TYPE; pt++) {
+    for(int sq = 0; sq < NUM_SQUARES; sq++) {
+      retval.pieceSquare[pt][sq] = splitmix64(state++);
+    }
+  }
+  for(int slot = 0; slot < NUM_PLAYERS * NUM_STARTING_PIECES; slot++) {
+    retval.healthPointsSeed[slot] = splitmix64(state++);
+  }
+  retval.side = splitmix64(state++);
+  return retval;
+}
+
+inline constexpr ZobristKeys zobristKeys = generateZobristKeys();
+
+constexpr uint64_t zobristHealthPointsKey(int slot, int healthPoints) {
+  return splitmix64(zobristKeys.healthPointsSeed[slot] ^ (uint64_t)(uint32_t) healthPoints);
+}
+
+/*
+ * Read-only view of one table row. Elements are built on the fly from the source square and
+ * the pooled destination square, so T is PlayerMove, PlayerAbility or int (destination only).
+ */
+template<typename T>
+class SquareList {
+  public:
+    class iterator {
+      public:
+        constexpr iterator(int srcIdx, const uint8_t* current): srcIdx(srcIdx), current(current) { }
+        constexpr T operator*() const { return makeEntry(srcIdx, *current); }
+        constexpr iterator& operator++() { current++; return *this; }
+        constexpr bool operator!=(const iterator& other) const { return current != other.current; }
+      private:
+        int srcIdx;
+        const uint8_t* current;
+    };
+
+    constexpr SquareList(int srcIdx, const uint8_t* first, const uint8_t* last):
+      srcIdx(srcIdx), first(first), last(last) { }
+    constexpr int size() const { return (int)(last - first); }
+    constexpr T operator[](int i) const { return makeEntry(srcIdx, first[i]); }
+    constexpr iterator begin() const { return iterator(srcIdx, first); }
+    constexpr iterator end() const { return iterator(srcIdx, last); }
+
+  private:
+    int srcIdx;
+    const uint8_t* first;
+    const uint8_t* last;
+
+    static constexpr T makeEntry(int srcIdx, int dstIdx) {
+      if constexpr (std::is_same_v<T, int>) {
+        return dstIdx;
+      } else {
+        return T(srcIdx, dstIdx);
+      }
+    }
+};
+
+} // namespace nichess
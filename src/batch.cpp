@@ -0,0 +1,138 @@
+#include "nichess/batch.hpp"
+#include "nichess/generator.hpp"
+#include "nichess/planes.hpp"
+
+#include <cstring>
+
+using namespace nichess;
+
+static const int NUM_SLOTS = NUM_PLAYERS * NUM_STARTING_PIECES;
+static const int P1_KING_SLOT = PLAYER_1 * NUM_STARTING_PIECES + KING_PIECE_INDEX;
+static const int P2_KING_SLOT = PLAYER_2 * NUM_STARTING_PIECES + KING_PIECE_INDEX;
+
+GameBatch::GameBatch(GameCache& gameCache, int numGames):
+  numGames(numGames),
+  scratch(gameCache),
+  startingPosition(gameCache),
+  squares(NUM_SLOTS * numGames),
+  healthPoints(NUM_SLOTS * numGames),
+  players(numGames),
+  moveNumbers(numGames)
+{
+  reset();
+}
+
+int GameBatch::size() const {
+  return numGames;
+}
+
+void GameBatch::reset(const uint8_t* mask) {
+  for(int i = 0; i < numGames; i++) {
+    if(mask == nullptr || mask[i] != 0) {
+      store(i, startingPosition);
+    }
+  }
+}
+
+/*
+ * actions[i] is played in game i and must be legal.
+ */
+void GameBatch::step(const PlayerAction* actions) {
+  for(int i = 0; i < numGames; i++) {
+    if(isOver(i)) continue;
+    load(i, scratch);
+    const PlayerAction& pa = actions[i];
+    scratch.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    store(i, scratch);
+  }
+}
+
+void GameBatch::gameOver(uint8_t* out) const {
+  for(int i = 0; i < numGames; i++) {
+    out[i] = isOver(i) ? 1 : 0;
+  }
+}
+
+void GameBatch::winner(int8_t* out) const {
+  const int16_t* p1KingHealthPoints = &healthPoints[P1_KING_SLOT * numGames];
+  const int16_t* p2KingHealthPoints = &healthPoints[P2_KING_SLOT * numGames];
+  for(int i = 0; i < numGames; i++) {
+    out[i] = p1KingHealthPoints[i] <= 0 ? PLAYER_2 : (p2KingHealthPoints[i] <= 0 ? PLAYER_1 : -1);
+  }
+}
+
+void GameBatch::currentPlayers(uint8_t* out) const {
+  std::memcpy(out, players.data(), numGames);
+}
+
+/*
+ * Writes numGames masks.
+ */
+void GameBatch::legalActionMasks(ActionMask* out) {
+  for(int i = 0; i < numGames; i++) {
+    if(isOver(i)) {
+      std::memset(out[i].moves, 0, sizeof(out[i].moves));
+      out[i].numMoves = 0;
+      continue;
+    }
+    load(i, scratch);
+    legalActionMask(scratch, out[i]);
+  }
+}
+
+void GameBatch::encodePlanes(float* out, bool sideToMove) const {
+  encodeAllPlanes(out, sideToMove);
+}
+
+void GameBatch::encodePlanes(int8_t* out, bool sideToMove) const {
+  encodeAllPlanes(out, sideToMove);
+}
+
+/*
+ * Reads the slot arrays directly, without loading the games.
+ */
+template<typename T>
+void GameBatch::encodeAllPlanes(T* out, bool sideToMove) const {
+  PieceType types[NUM_SLOTS];
+  int squareIndices[NUM_SLOTS];
+  int slotHealthPoints[NUM_SLOTS];
+  for(int slot = 0; slot < NUM_SLOTS; slot++) {
+    types[slot] = startingPosition.pieces[slot / NUM_STARTING_PIECES][slot % NUM_STARTING_PIECES].type;
+  }
+  for(int i = 0; i < numGames; i++) {
+    for(int slot = 0; slot < NUM_SLOTS; slot++) {
+      squareIndices[slot] = squares[slot * numGames + i];
+      slotHealthPoints[slot] = healthPoints[slot * numGames + i];
+    }
+    nichess::encodePlanes(types, squareIndices, slotHealthPoints, (Player) players[i], sideToMove,
+        out + (size_t) i * INPUT_PLANES_SIZE);
+  }
+}
+
+/*
+ * Copies game gameIndex into game, which must use the same GameCache.
+ */
+void GameBatch::load(int gameIndex, Game& game) const {
+  for(int slot = 0; slot < NUM_SLOTS; slot++) {
+    Piece& piece = game.pieces[slot / NUM_STARTING_PIECES][slot % NUM_STARTING_PIECES];
+    piece.squareIndex = squares[slot * numGames + gameIndex];
+    piece.healthPoints = healthPoints[slot * numGames + gameIndex];
+  }
+  game.currentPlayer = (Player) players[gameIndex];
+  game.moveNumber = moveNumbers[gameIndex];
+  game.placePieces();
+}
+
+void GameBatch::store(int gameIndex, const Game& game) {
+  for(int slot = 0; slot < NUM_SLOTS; slot++) {
+    const Piece& piece = game.pieces[slot / NUM_STARTING_PIECES][slot % NUM_STARTING_PIECES];
+    squares[slot * numGames + gameIndex] = (uint8_t) piece.squareIndex;
+    healthPoints[slot * numGames + gameIndex] = (int16_t) piece.healthPoints;
+  }
+  players[gameIndex] = (uint8_t) game.currentPlayer;
+  moveNumbers[gameIndex] = game.moveNumber;
+}
+
+bool GameBatch::isOver(int gameIndex) const {
+  return healthPoints[P1_KING_SLOT * numGames + gameIndex] <= 0 || healthPoints[P2_KING_SLOT * numGames + gameIndex] <= 0;
+}
@@ -0,0 +1,368 @@
+#include "nichess/bitboard.hpp"
+#include "nichess/util.hpp"
+
+#include <sstream>
+
+using namespace nichess;
+
+BitboardUndoInfo::BitboardUndoInfo():
+  moveSrcIdx(MOVE_SKIP),
+  moveDstIdx(MOVE_SKIP),
+  abilityType(NO_ABILITY),
+  affectedSlots(0),
+  killedSlots(0)
+{ }
+
+BitboardGame::BitboardGame(GameCache& gameCache) {
+  this->gameCache = &gameCache;
+  reset();
+}
+
+BitboardGame::BitboardGame(GameCache& gameCache, const std::string encodedBoard) {
+  this->gameCache = &gameCache;
+  boardFromString(encodedBoard);
+}
+
+void BitboardGame::addPiece(Player player, int slot, int healthPoints, int squareIndex) {
+  uint64_t mask = squareMask(squareIndex);
+  this->healthPoints[player][slot] = healthPoints;
+  pieceSquare[player][slot] = squareIndex;
+  squareSlots[squareIndex] = slot;
+  pieceTypeToOccupancy[slotToPieceType[player][slot]] |= mask;
+  playerToOccupancy[player] |= mask;
+}
+
+/*
+ * Removes the piece from bitboards. Health points and square are left untouched so that
+ * the piece can be revived by undoAction, squareSlots of an empty square is never read.
+ */
+void BitboardGame::removePiece(Player player, int slot) {
+  uint64_t mask = ~squareMask(pieceSquare[player][slot]);
+  pieceTypeToOccupancy[slotToPieceType[player][slot]] &= mask;
+  playerToOccupancy[player] &= mask;
+}
+
+void BitboardGame::reset() {
+  moveNumber = 0;
+  currentPlayer = Player::PLAYER_1;
+  for(int i = 0; i < NUM_PIECE_TYPE - 1; i++) {
+    pieceTypeToOccupancy[i] = 0;
+  }
+  playerToOccupancy[PLAYER_1] = 0;
+  playerToOccupancy[PLAYER_2] = 0;
+
+  addPiece(PLAYER_1, KING_PIECE_INDEX, KING_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,0));
+  addPiece(PLAYER_1, PAWN_1_PIECE_INDEX, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,1));
+  addPiece(PLAYER_1, PAWN_2_PIECE_INDEX, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(1,1));
+  addPiece(PLAYER_1, ASSASSIN_PIECE_INDEX, ASSASSIN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,0));
+  addPiece(PLAYER_1, WARRIOR_PIECE_INDEX, WARRIOR_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(3,1));
+  addPiece(PLAYER_1, MAGE_PIECE_INDEX, MAGE_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(4,1));
+  addPiece(PLAYER_1, PAWN_3_PIECE_INDEX, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(5,1));
+
+  addPiece(PLAYER_2, KING_PIECE_INDEX, KING_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,7));
+  addPiece(PLAYER_2, PAWN_1_PIECE_INDEX, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,6));
+  addPiece(PLAYER_2, PAWN_2_PIECE_INDEX, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(6,6));
+  addPiece(PLAYER_2, ASSASSIN_PIECE_INDEX, ASSASSIN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,7));
+  addPiece(PLAYER_2, WARRIOR_PIECE_INDEX, WARRIOR_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(4,6));
+  addPiece(PLAYER_2, MAGE_PIECE_INDEX, MAGE_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(3,6));
+  addPiece(PLAYER_2, PAWN_3_PIECE_INDEX, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(2,6));
+}
+
+/*
+ * Returns the slot of the living piece that belongs to player and stands on squareIndex,
+ * or -1 if there is no such piece.
+ */
+int BitboardGame::slotBySquareIndex(Player player, int squareIndex) const {
+  if((playerToOccupancy[player] & squareMask(squareIndex)) == 0) return -1;
+  return squareSlots[squareIndex];
+}
+
+Piece BitboardGame::getPieceBySquareIndex(int squareIndex) const {
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    int slot = slotBySquareIndex(Player(p), squareIndex);
+    if(slot != -1) {
+      return Piece(slotToPieceType[p][slot], healthPoints[p][slot], squareIndex);
+    }
+  }
+  return Piece(PieceType::NO_PIECE, 0, squareIndex);
+}
+
+void BitboardGame::makeMove(int moveSrcIdx, int moveDstIdx) {
+  int slot = squareSlots[moveSrcIdx];
+  uint64_t mask = squareMask(moveSrcIdx) | squareMask(moveDstIdx);
+  pieceTypeToOccupancy[slotToPieceType[currentPlayer][slot]] ^= mask;
+  playerToOccupancy[currentPlayer] ^= mask;
+  pieceSquare[currentPlayer][slot] = moveDstIdx;
+  squareSlots[moveDstIdx] = slot;
+}
+
+/*
+ * Since move is being reverted, goal here is to move from "destination" to "source".
+ */
+void BitboardGame::undoMove(int moveSrcIdx, int moveDstIdx) {
+  int slot = squareSlots[moveDstIdx];
+  uint64_t mask = squareMask(moveSrcIdx) | squareMask(moveDstIdx);
+  pieceTypeToOccupancy[slotToPieceType[currentPlayer][slot]] ^= mask;
+  playerToOccupancy[currentPlayer] ^= mask;
+  pieceSquare[currentPlayer][slot] = moveSrcIdx;
+  squareSlots[moveSrcIdx] = slot;
+}
+
+/*
+ * Same rules as Game::makeAction. Assumes that the move and ability are legal.
+ * Abilities that don't alter the game state are converted to AbilityType::NO_ABILITY.
+ */
+BitboardUndoInfo BitboardGame::makeAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
+  BitboardUndoInfo undoInfo;
+  undoInfo.moveSrcIdx = moveSrcIdx;
+  undoInfo.moveDstIdx = moveDstIdx;
+  if(moveSrcIdx != MOVE_SKIP) {
+    makeMove(moveSrcIdx, moveDstIdx);
+  }
+  Player enemy = ~currentPlayer;
+  if(abilitySrcIdx != ABILITY_SKIP && (playerToOccupancy[enemy] & squareMask(abilityDstIdx))) {
+    int attackerSlot = squareSlots[abilitySrcIdx];
+    PieceType attackerType = slotToPieceType[currentPlayer][attackerSlot];
+    AbilityType abilityType = pieceTypeToAbilityType[attackerType];
+    int abilityPoints = abilityTypeToAbilityPoints[abilityType];
+    // mage damages attacked piece and all enemy pieces that are touching it
+    uint64_t targets = squareMask(abilityDstIdx);
+    if(abilityType == MAGE_DAMAGE) {
+      targets |= gameCache->neighboringSquaresMask(abilityDstIdx) & playerToOccupancy[enemy];
+    }
+    undoInfo.abilityType = abilityType;
+    while(targets) {
+      int slot = squareSlots[popLsb(targets)];
+      healthPoints[enemy][slot] -= abilityPoints;
+      undoInfo.affectedSlots |= 1 << slot;
+      if(healthPoints[enemy][slot] <= 0) {
+        undoInfo.killedSlots |= 1 << slot;
+        removePiece(enemy, slot);
+      }
+    }
+  }
+  this->moveNumber += 1;
+  this->currentPlayer = ~currentPlayer;
+  return undoInfo;
+}
+
+void BitboardGame::undoAction(const BitboardUndoInfo& undoInfo) {
+  this->moveNumber -= 1;
+  this->currentPlayer = ~currentPlayer;
+  // undo ability
+  if(undoInfo.abilityType != NO_ABILITY) {
+    Player enemy = ~currentPlayer;
+    int abilityPoints = abilityTypeToAbilityPoints[undoInfo.abilityType];
+    for(int slot = 0; slot < NUM_STARTING_PIECES; slot++) {
+      if((undoInfo.affectedSlots & (1 << slot)) == 0) continue;
+      healthPoints[enemy][slot] += abilityPoints;
+      if(undoInfo.killedSlots & (1 << slot)) {
+        addPiece(enemy, slot, healthPoints[enemy][slot], pieceSquare[enemy][slot]);
+      }
+    }
+  }
+  // undo move
+  if(undoInfo.moveSrcIdx != MOVE_SKIP) {
+    undoMove(undoInfo.moveSrcIdx, undoInfo.moveDstIdx);
+  }
+}
+
+/*
+ * Destination squares of the piece in the given slot, excluding occupied squares and pawn
+ * jumps over another piece.
+ */
+uint64_t BitboardGame::legalMovesMask(Player player, int slot, uint64_t occupied) const {
+  PieceType pt = slotToPieceType[player][slot];
+  int src = pieceSquare[player][slot];
+  uint64_t moves = gameCache->legalMovesMask(pt, src) & ~occupied;
+  if(pt == P1_PAWN && src + 2 * NUM_COLUMNS < NUM_SQUARES &&
+      (occupied & squareMask(src + NUM_COLUMNS))) {
+    moves &= ~squareMask(src + 2 * NUM_COLUMNS);
+  } else if(pt == P2_PAWN && src - 2 * NUM_COLUMNS >= 0 &&
+      (occupied & squareMask(src - NUM_COLUMNS))) {
+    moves &= ~squareMask(src - 2 * NUM_COLUMNS);
+  }
+  return moves;
+}
+
+/*
+ * Useful actions are those whose abilities change the game state, i.e. abilities that target
+ * an enemy piece.
+ */
+std::vector<PlayerAction> BitboardGame::usefulLegalActions() {
+  std::vector<PlayerAction> retval;
+  // If King is dead, game is over and there are no legal actions
+  if(healthPoints[currentPlayer][KING_PIECE_INDEX] <= 0) {
+    return retval;
+  }
+  Player enemy = ~currentPlayer;
+  uint64_t enemyOccupancy = playerToOccupancy[enemy];
+  for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+    if(healthPoints[currentPlayer][i] <= 0) continue; // dead pieces don't move
+    int moveSrcIdx = pieceSquare[currentPlayer][i];
+    uint64_t moves = legalMovesMask(currentPlayer, i, playerToOccupancy[PLAYER_1] | playerToOccupancy[PLAYER_2]);
+    while(moves) {
+      int moveDstIdx = popLsb(moves);
+      pieceSquare[currentPlayer][i] = moveDstIdx;
+      for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+        if(healthPoints[currentPlayer][k] <= 0) continue; // no abilities for dead pieces
+        int abilitySrcIdx = pieceSquare[currentPlayer][k];
+        uint64_t targets = gameCache->legalAbilitiesMask(slotToPieceType[currentPlayer][k], abilitySrcIdx) & enemyOccupancy;
+        while(targets) {
+          retval.push_back(PlayerAction(moveSrcIdx, moveDstIdx, abilitySrcIdx, popLsb(targets)));
+        }
+      }
+      // player can skip the ability
+      retval.push_back(PlayerAction(moveSrcIdx, moveDstIdx, ABILITY_SKIP, ABILITY_SKIP));
+    }
+    pieceSquare[currentPlayer][i] = moveSrcIdx;
+  }
+  // player can skip the move
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    if(healthPoints[currentPlayer][k] <= 0) continue; // no abilities for dead pieces
+    int abilitySrcIdx = pieceSquare[currentPlayer][k];
+    uint64_t targets = gameCache->legalAbilitiesMask(slotToPieceType[currentPlayer][k], abilitySrcIdx) & enemyOccupancy;
+    while(targets) {
+      retval.push_back(PlayerAction(MOVE_SKIP, MOVE_SKIP, abilitySrcIdx, popLsb(targets)));
+    }
+  }
+  // player can skip both move and ability
+  retval.push_back(PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP));
+  return retval;
+}
+
+/*
+ * Includes actions with useless abilities (i.e. those that don't alter the game state)
+ */
+std::vector<PlayerAction> BitboardGame::allLegalActions() {
+  std::vector<PlayerAction> retval;
+  // If King is dead, game is over and there are no legal actions
+  if(healthPoints[currentPlayer][KING_PIECE_INDEX] <= 0) {
+    return retval;
+  }
+  uint64_t occupied = playerToOccupancy[PLAYER_1] | playerToOccupancy[PLAYER_2];
+  for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+    if(healthPoints[currentPlayer][i] <= 0) continue; // dead pieces don't move
+    int moveSrcIdx = pieceSquare[currentPlayer][i];
+    uint64_t moves = legalMovesMask(currentPlayer, i, occupied);
+    while(moves) {
+      int moveDstIdx = popLsb(moves);
+      // friendly occupancy after the move
+      uint64_t friendly = playerToOccupancy[currentPlayer] ^ squareMask(moveSrcIdx) ^ squareMask(moveDstIdx);
+      pieceSquare[currentPlayer][i] = moveDstIdx;
+      for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+        if(healthPoints[currentPlayer][k] <= 0) continue; // no abilities for dead pieces
+        int abilitySrcIdx = pieceSquare[currentPlayer][k];
+        uint64_t targets = gameCache->legalAbilitiesMask(slotToPieceType[currentPlayer][k], abilitySrcIdx) & ~friendly;
+        while(targets) {
+          retval.push_back(PlayerAction(moveSrcIdx, moveDstIdx, abilitySrcIdx, popLsb(targets)));
+        }
+      }
+      // player can skip the ability
+      retval.push_back(PlayerAction(moveSrcIdx, moveDstIdx, ABILITY_SKIP, ABILITY_SKIP));
+    }
+    pieceSquare[currentPlayer][i] = moveSrcIdx;
+  }
+  // player can skip the move
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    if(healthPoints[currentPlayer][k] <= 0) continue; // no abilities for dead pieces
+    int abilitySrcIdx = pieceSquare[currentPlayer][k];
+    uint64_t targets = gameCache->legalAbilitiesMask(slotToPieceType[currentPlayer][k], abilitySrcIdx) & ~playerToOccupancy[currentPlayer];
+    while(targets) {
+      retval.push_back(PlayerAction(MOVE_SKIP, MOVE_SKIP, abilitySrcIdx, popLsb(targets)));
+    }
+  }
+  // player can skip both move and ability
+  retval.push_back(PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP));
+  return retval;
+}
+
+bool BitboardGame::gameOver() const {
+  return healthPoints[PLAYER_1][KING_PIECE_INDEX] <= 0 || healthPoints[PLAYER_2][KING_PIECE_INDEX] <= 0;
+}
+
+std::optional<Player> BitboardGame::winner() const {
+  if(healthPoints[PLAYER_1][KING_PIECE_INDEX] <= 0) {
+    return PLAYER_2;
+  } else if(healthPoints[PLAYER_2][KING_PIECE_INDEX] <= 0) {
+    return PLAYER_1;
+  }
+  return std::nullopt;
+}
+
+/*
+ * Same format as Game::boardToString.
+ */
+std::string BitboardGame::boardToString() const {
+  std::stringstream retval;
+  retval << currentPlayer << "|";
+  for(int i = 0; i < NUM_SQUARES; i++) {
+    Piece currentPiece = getPieceBySquareIndex(i);
+    retval << pieceTypeTokens[currentPiece.type];
+    if(currentPiece.type == NO_PIECE) {
+      retval << ",";
+      continue;
+    }
+    retval << currentPiece.healthPoints << ",";
+  }
+  return retval.str();
+}
+
+/*
+ * Same format and errors as Game::boardFromString, throws if encodedBoard can't be parsed.
+ */
+void BitboardGame::boardFromString(std::string encodedBoard) {
+  ParseError error = parseBoard(encodedBoard);
+  if(error != PARSE_OK) {
+    throw parseErrorToString(error);
+  }
+}
+
+/*
+ * Same parser as Game::parseBoard. Pieces that aren't on the board are dead. On error the game
+ * is left unchanged.
+ */
+ParseError BitboardGame::parseBoard(std::string_view encodedBoard) {
+  Player parsedPlayer;
+  Piece parsed[NUM_PLAYERS][NUM_STARTING_PIECES];
+  ParseError error = parseBoardPieces(encodedBoard, parsedPlayer, parsed);
+  if(error != PARSE_OK) return error;
+  currentPlayer = parsedPlayer;
+  moveNumber = 0;
+  for(int i = 0; i < NUM_PIECE_TYPE - 1; i++) {
+    pieceTypeToOccupancy[i] = 0;
+  }
+  playerToOccupancy[PLAYER_1] = 0;
+  playerToOccupancy[PLAYER_2] = 0;
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      healthPoints[p][i] = 0;
+      pieceSquare[p][i] = 0;
+      if(parsed[p][i].healthPoints > 0) {
+        addPiece(Player(p), i, parsed[p][i].healthPoints, parsed[p][i].squareIndex);
+      }
+    }
+  }
+  return PARSE_OK;
+}
+
+/*
+ * Same as nichess::perft(Game&, int), with bulk counting.
+ */
+unsigned long long nichess::perft(BitboardGame& game, int depth) {
+  unsigned long long nodes = 0;
+  std::vector<PlayerAction> legalActions = game.usefulLegalActions();
+  int numLegalActions = legalActions.size();
+  if(depth == 1) {
+    return (unsigned long long) numLegalActions;
+  }
+
+  BitboardUndoInfo ui;
+  for(int i = 0; i < numLegalActions; i++) {
+    PlayerAction pa = legalActions[i];
+    ui = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    nodes += perft(game, depth-1);
+    game.undoAction(ui);
+  }
+  return nodes;
+}
@@ -0,0 +1,12 @@
+#include "nichess/evaluate.hpp"
+
+using namespace nichess;
+
+int nichess::evaluate(const Game& game) {
+  const Accumulators& accumulators = game.accumulators();
+  Player us = game.currentPlayer;
+  Player them = ~us;
+  return accumulators.healthPoints[us] - accumulators.healthPoints[them] +
+    accumulators.material[us] - accumulators.material[them] +
+    KING_ZONE_WEIGHT * (accumulators.kingZonePieces[them] - accumulators.kingZonePieces[us]);
+}
@@ -0,0 +1,232 @@
+#include "nichess/generator.hpp"
+#include "nichess/util.hpp"
+#include "nichess/actionindex.hpp"
+#include "nichess/bitboard.hpp"
+
+#include <cstring>
+
+using namespace nichess;
+
+bool nichess::isMoveLegal(const Game& game, const Piece* piece, int moveDstIdx) {
+  // Is p1 pawn trying to jump over another piece?
+  if(piece->type == P1_PAWN && moveDstIdx - piece->squareIndex == 2 * NUM_COLUMNS) {
+    if(!game.isSquareEmpty(piece->squareIndex + NUM_COLUMNS)) return false;
+  }
+  // Is p2 pawn trying to jump over another piece?
+  if(piece->type == P2_PAWN && piece->squareIndex - moveDstIdx == 2 * NUM_COLUMNS) {
+    if(!game.isSquareEmpty(piece->squareIndex - NUM_COLUMNS)) return false;
+  }
+  return game.isSquareEmpty(moveDstIdx);
+}
+
+int nichess::usefulAbilities(const Game& game, const Piece* piece, int abilitySrcIdx, PlayerAbility* out) {
+  int n = 0;
+  for(PlayerAbility ability: game.gameCache->legalAbilities(piece->type, abilitySrcIdx)) {
+    if(abilityEffectTable.effects[piece->type][game.pieceAt(ability.abilityDstIdx)->type].useful) {
+      out[n++] = ability;
+    }
+  }
+  return n;
+}
+
+/*
+ * Ability indices of the useful abilities of a piece used from abilitySrcIdx.
+ */
+static int usefulAbilityIndices(const Game& game, const Piece* piece, int abilitySrcIdx, uint64_t enemies, int* out) {
+  int n = 0;
+  for(uint64_t targets = game.gameCache->legalAbilitiesMask(piece->type, abilitySrcIdx) & enemies; targets != 0; ) {
+    out[n++] = abilityPairTable.pairIndices[abilitySrcIdx][popLsb(targets)];
+  }
+  return n;
+}
+
+static inline void setMaskBit(uint64_t* mask, int index) {
+  mask[index / 64] |= 1ULL << (index % 64);
+}
+
+/*
+ * Adds the row of a move to the mask and returns its ability mask, left uninitialised.
+ */
+static inline uint64_t* addMoveRow(ActionMask& mask, int moveIndex) {
+  setMaskBit(mask.moves, moveIndex);
+  mask.moveIndices[mask.numMoves] = (int16_t) moveIndex;
+  return mask.abilities[mask.numMoves++];
+}
+
+/*
+ * Same decomposition as ActionGenerator: abilities of the pieces that don't move are the same
+ * after every move, only the moving piece's abilities are recomputed from its destination.
+ * The abilities of the other pieces are collected once per moving piece and copied into the
+ * row of each of its moves.
+ */
+void nichess::legalActionMask(const Game& game, ActionMask& mask) {
+  std::memset(mask.moves, 0, sizeof(mask.moves));
+  mask.numMoves = 0;
+  Player currentPlayer = game.currentPlayer;
+  // If King is dead, game is over and there are no legal actions
+  if(game.playerPiece(currentPlayer, KING_PIECE_INDEX)->healthPoints <= 0) return;
+
+  uint64_t enemies = game.playerOccupancy(~currentPlayer);
+  uint64_t empty = ~(enemies | game.playerOccupancy(currentPlayer));
+  int abilityIndices[NUM_STARTING_PIECES][NUM_STARTING_PIECES];
+  int numAbilityIndices[NUM_STARTING_PIECES];
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    const Piece* piece = game.playerPiece(currentPlayer, k);
+    // no abilities for dead pieces
+    numAbilityIndices[k] = piece->healthPoints > 0 ? usefulAbilityIndices(game, piece, piece->squareIndex, enemies, abilityIndices[k]) : 0;
+  }
+
+  uint64_t* skipRow = addMoveRow(mask, MOVE_SKIP_INDEX);
+  std::memset(skipRow, 0, sizeof(uint64_t) * ABILITY_MASK_WORDS);
+  setMaskBit(skipRow, ABILITY_SKIP_INDEX);
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    for(int a = 0; a < numAbilityIndices[k]; a++) {
+      setMaskBit(skipRow, abilityIndices[k][a]);
+    }
+  }
+
+  uint64_t others[ABILITY_MASK_WORDS];
+  int movedAbilityIndices[NUM_STARTING_PIECES];
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    const Piece* piece = game.playerPiece(currentPlayer, k);
+    if(piece->healthPoints <= 0) continue; // dead pieces don't move
+    int srcIdx = piece->squareIndex;
+    uint64_t moves = game.gameCache->legalMovesMask(piece->type, srcIdx) & empty;
+    if(moves == 0) continue;
+    std::memset(others, 0, sizeof(others));
+    setMaskBit(others, ABILITY_SKIP_INDEX);
+    for(int other = 0; other < NUM_STARTING_PIECES; other++) {
+      if(other == k) continue;
+      for(int a = 0; a < numAbilityIndices[other]; a++) {
+        setMaskBit(others, abilityIndices[other][a]);
+      }
+    }
+    while(moves != 0) {
+      int dstIdx = popLsb(moves);
+      if(!isMoveLegal(game, piece, dstIdx)) continue;
+      uint64_t* row = addMoveRow(mask, movePairTable.pairIndices[srcIdx][dstIdx]);
+      std::memcpy(row, others, sizeof(others));
+      int n = usefulAbilityIndices(game, piece, dstIdx, enemies, movedAbilityIndices);
+      for(int a = 0; a < n; a++) {
+        setMaskBit(row, movedAbilityIndices[a]);
+      }
+    }
+  }
+}
+
+ActionGenerator::ActionGenerator(const Game& game): game(&game) {
+  reset();
+}
+
+/*
+ * Starts generating again from the first action, e.g. after the game has changed.
+ */
+void ActionGenerator::reset() {
+  currentStage = ABILITIES;
+  started = false;
+}
+
+ActionGenerator::Stage ActionGenerator::stage() const {
+  return currentStage;
+}
+
+/*
+ * Collects the useful abilities of the current position. Called on the first next().
+ */
+void ActionGenerator::start() {
+  started = true;
+  numAbilities = 0;
+  abilityIdx = 0;
+  Player currentPlayer = game->currentPlayer;
+  // If King is dead, game is over and there are no legal actions
+  if(game->playerPiece(currentPlayer, KING_PIECE_INDEX)->healthPoints <= 0) {
+    currentStage = DONE;
+    return;
+  }
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    const Piece* piece = game->playerPiece(currentPlayer, k);
+    if(piece->healthPoints <= 0) continue; // no abilities for dead pieces
+    int n = usefulAbilities(*game, piece, piece->squareIndex, &abilities[numAbilities]);
+    for(int i = 0; i < n; i++) {
+      abilitySlots[numAbilities++] = k;
+    }
+  }
+}
+
+bool ActionGenerator::next(PlayerAction& action) {
+  if(!started) start();
+  while(true) {
+    switch(currentStage) {
+      case ABILITIES:
+        if(abilityIdx < numAbilities) {
+          const PlayerAbility& ability = abilities[abilityIdx++];
+          action = PlayerAction(MOVE_SKIP, MOVE_SKIP, ability.abilitySrcIdx, ability.abilityDstIdx);
+          return true;
+        }
+        currentStage = MOVES_WITH_ABILITIES;
+        pieceSlot = 0;
+        moveIdx = -1;
+        numMovedAbilities = 0;
+        movedAbilityIdx = 0;
+        break;
+      case MOVES_WITH_ABILITIES:
+        // abilities of the pieces that didn't move
+        while(abilityIdx < numAbilities) {
+          int i = abilityIdx++;
+          if(abilitySlots[i] == pieceSlot) continue;
+          action = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, abilities[i].abilitySrcIdx, abilities[i].abilityDstIdx);
+          return true;
+        }
+        // abilities of the moved piece
+        if(movedAbilityIdx < numMovedAbilities) {
+          const PlayerAbility& ability = movedAbilities[movedAbilityIdx++];
+          action = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, ability.abilitySrcIdx, ability.abilityDstIdx);
+          return true;
+        }
+        if(!nextMove(currentMove)) {
+          currentStage = PLAIN_MOVES;
+          pieceSlot = 0;
+          moveIdx = -1;
+          break;
+        }
+        numMovedAbilities = usefulAbilities(*game, game->playerPiece(game->currentPlayer, pieceSlot), currentMove.moveDstIdx, movedAbilities);
+        movedAbilityIdx = 0;
+        abilityIdx = 0;
+        break;
+      case PLAIN_MOVES:
+        if(nextMove(currentMove)) {
+          action = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, ABILITY_SKIP, ABILITY_SKIP);
+          return true;
+        }
+        // stage() reports SKIP for the skip action, DONE only once next() returns false
+        currentStage = SKIP;
+        action = PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+        return true;
+      case SKIP:
+        currentStage = DONE;
+        break;
+      case DONE:
+        return false;
+    }
+  }
+}
+
+/*
+ * Advances (pieceSlot, moveIdx) to the next legal move.
+ */
+bool ActionGenerator::nextMove(PlayerMove& move) {
+  Player currentPlayer = game->currentPlayer;
+  while(pieceSlot < NUM_STARTING_PIECES) {
+    const Piece* piece = game->playerPiece(currentPlayer, pieceSlot);
+    if(piece->healthPoints > 0) { // dead pieces don't move
+      auto legalMoves = game->gameCache->legalMoves(piece->type, piece->squareIndex);
+      while(++moveIdx < legalMoves.size()) {
+        move = legalMoves[moveIdx];
+        if(isMoveLegal(*game, piece, move.moveDstIdx)) return true;
+      }
+    }
+    pieceSlot++;
+    moveIdx = -1;
+  }
+  return false;
+}
@@ -0,0 +1,523 @@
+#include "nichess/mcts.hpp"
+#include "nichess/generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+using namespace nichess;
+
+// Time budget is checked every this many playouts
+static const unsigned long long PLAYOUTS_BETWEEN_CHECKS = 64;
+// PUCT value of children without visits
+static const float FIRST_PLAY_VALUE = 0.5f;
+// Tree depth the playout buffers are reserved for, deeper paths grow them once
+static const int RESERVED_TREE_DEPTH = 256;
+// MctsNode::children while a thread is filling in the child block
+static const uint64_t CHILDREN_EXPANDING = 1ull << 63;
+// End of a free block list
+static const uint32_t NO_NODE = UINT32_MAX;
+
+/*
+ * std::atomic<float> has no fetch_add before C++20.
+ */
+static void addValue(std::atomic<float>& sum, float value) {
+  float current = sum.load(std::memory_order_relaxed);
+  while(!sum.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) { }
+}
+
+/*
+ * Playout result for player 1 when the game isn't over: 0.5 plus the share of the
+ * health point balance.
+ */
+static float healthPointsValue(const Game& game) {
+  const int* healthPoints = game.accumulators().healthPoints;
+  int total = healthPoints[PLAYER_1] + healthPoints[PLAYER_2];
+  if(total == 0) return 0.5f;
+  return 0.5f + 0.5f * (float)(healthPoints[PLAYER_1] - healthPoints[PLAYER_2]) / (float) total;
+}
+
+MctsConfig::MctsConfig():
+  selectionPolicy(UCT),
+  explorationConstant(1.4),
+  rolloutPolicy(RANDOM_ROLLOUT),
+  maxRolloutPlies(200),
+  maxPlayouts(10000),
+  maxSeconds(0),
+  maxNodes(1 << 20),
+  seed(0),
+  numThreads(1)
+{ }
+
+MctsNode::MctsNode():
+  moveSrcIdx(MOVE_SKIP),
+  moveDstIdx(MOVE_SKIP),
+  abilitySrcIdx(ABILITY_SKIP),
+  abilityDstIdx(ABILITY_SKIP),
+  prior(0),
+  children(0),
+  visits(0),
+  virtualLosses(0),
+  valueSum(0)
+{ }
+
+/*
+ * Only called on nodes that no other thread can reach.
+ */
+void MctsNode::reset(const PlayerAction& pa, float prior) {
+  moveSrcIdx = pa.moveSrcIdx;
+  moveDstIdx = pa.moveDstIdx;
+  abilitySrcIdx = pa.abilitySrcIdx;
+  abilityDstIdx = pa.abilityDstIdx;
+  this->prior = prior;
+  children.store(0, std::memory_order_relaxed);
+  visits.store(0, std::memory_order_relaxed);
+  virtualLosses.store(0, std::memory_order_relaxed);
+  valueSum.store(0, std::memory_order_relaxed);
+}
+
+PlayerAction MctsNode::action() const {
+  return PlayerAction(moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx);
+}
+
+bool MctsNode::expanded() const {
+  uint64_t c = children.load(std::memory_order_acquire);
+  return c != 0 && (c & CHILDREN_EXPANDING) == 0;
+}
+
+uint32_t MctsNode::firstChild() const {
+  return (uint32_t) children.load(std::memory_order_acquire);
+}
+
+uint32_t MctsNode::numChildren() const {
+  uint64_t c = children.load(std::memory_order_acquire);
+  return (c & CHILDREN_EXPANDING) != 0 ? 0 : (uint32_t) (c >> 32);
+}
+
+namespace nichess {
+
+/*
+ * Playout buffers and random number generator of one thread.
+ */
+class MctsWorker {
+  public:
+    std::mt19937_64 rng;
+    ActionList actions;
+    std::vector<float> priors;
+    std::vector<uint32_t> path;
+    std::vector<UndoInfo> undoInfos;
+
+    MctsWorker(uint64_t seed, int maxRolloutPlies): rng(seed), priors(MAX_NUM_ACTIONS) {
+      path.reserve(RESERVED_TREE_DEPTH);
+      undoInfos.reserve(RESERVED_TREE_DEPTH + maxRolloutPlies);
+    }
+};
+
+} // namespace nichess
+
+Mcts::Mcts(const MctsConfig& config):
+  config(config),
+  nodes(std::max(config.maxNodes, (uint32_t) 1)),
+  freeBlocks(MAX_NUM_ACTIONS + 1)
+{
+  if(config.maxPlayouts == 0 && config.maxSeconds <= 0) {
+    throw "Mcts needs a playout or time budget";
+  }
+  int numThreads = config.numThreads > 0 ? config.numThreads : std::max(1, (int) std::thread::hardware_concurrency());
+  for(int i = 0; i < numThreads; i++) {
+    workers.push_back(std::make_unique<MctsWorker>(config.seed + i, config.maxRolloutPlies));
+  }
+  clear();
+}
+
+Mcts::~Mcts() { }
+
+/*
+ * Drops the whole tree.
+ */
+void Mcts::clear() {
+  nodes[0].reset(PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP), 0);
+  nextFreeNode = 1;
+  for(std::atomic<uint32_t>& head: freeBlocks) {
+    head.store(NO_NODE, std::memory_order_relaxed);
+  }
+  numFreeNodes = 0;
+  playouts = 0;
+  rootKeyKnown = false;
+}
+
+/*
+ * Makes the child of pa the new root and frees everything else, in time proportional to the
+ * number of freed nodes. Returns false and clears the tree if pa isn't in the tree.
+ * game is the position after pa, the next search only continues from the kept tree if it's
+ * given that position.
+ */
+bool Mcts::advance(const PlayerAction& pa, const Game& game) {
+  MctsNode& root = nodes[0];
+  uint32_t firstChild = root.firstChild();
+  uint32_t numChildren = root.numChildren();
+  uint32_t kept = NO_NODE;
+  for(uint32_t i = firstChild; i < firstChild + numChildren; i++) {
+    const MctsNode& child = nodes[i];
+    if(child.moveSrcIdx == pa.moveSrcIdx && child.moveDstIdx == pa.moveDstIdx &&
+        child.abilitySrcIdx == pa.abilitySrcIdx && child.abilityDstIdx == pa.abilityDstIdx) {
+      kept = i;
+      break;
+    }
+  }
+  if(kept == NO_NODE) {
+    clear();
+    return false;
+  }
+  for(uint32_t i = firstChild; i < firstChild + numChildren; i++) {
+    if(i != kept) freeSubtree(i);
+  }
+  // the root stays at index 0 and takes over the children and statistics of the kept node
+  root.children.store(nodes[kept].children.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  root.visits.store(nodes[kept].visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  root.valueSum.store(nodes[kept].valueSum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  pushFreeBlock(firstChild, numChildren);
+  rootKey = game.hash();
+  rootKeyKnown = true;
+  return true;
+}
+
+const MctsNode& Mcts::root() const {
+  return nodes[0];
+}
+
+const MctsNode& Mcts::node(uint32_t index) const {
+  return nodes[index];
+}
+
+uint32_t Mcts::numNodes() const {
+  return nextFreeNode - numFreeNodes;
+}
+
+unsigned long long Mcts::numPlayouts() const {
+  return playouts;
+}
+
+/*
+ * Searches within the configured budget and returns the most visited action. The tree of
+ * the previous search or advance is reused if it belongs to this position.
+ * Game is left in its original state.
+ */
+PlayerAction Mcts::search(Game& game) {
+  if(rootKeyKnown && rootKey != game.hash()) {
+    clear();
+  }
+  rootKey = game.hash();
+  rootKeyKnown = true;
+  playouts = 0;
+  if(game.gameOver()) {
+    return root().action();
+  }
+  auto deadline = std::chrono::steady_clock::now() +
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(config.maxSeconds));
+  stopped = false;
+
+  // copies are made before the calling thread starts changing game
+  std::vector<Game> games;
+  std::vector<std::thread> threads;
+  if(workers.size() > 1) {
+    games.reserve(workers.size() - 1);
+    threads.reserve(workers.size() - 1);
+    for(size_t i = 1; i < workers.size(); i++) {
+      games.emplace_back(game);
+    }
+    for(size_t i = 1; i < workers.size(); i++) {
+      threads.emplace_back([this, &games, i, deadline]() { work(*workers[i], games[i - 1], deadline); });
+    }
+  }
+  work(*workers[0], game, deadline);
+  for(std::thread& thread: threads) {
+    thread.join();
+  }
+  return nodes[bestChild()].action();
+}
+
+void Mcts::work(MctsWorker& worker, Game& game, std::chrono::steady_clock::time_point deadline) {
+  unsigned long long workerPlayouts = 0;
+  while(!stopped.load(std::memory_order_relaxed) && reservePlayout()) {
+    playout(worker, game);
+    workerPlayouts++;
+    if(config.maxSeconds > 0 && workerPlayouts % PLAYOUTS_BETWEEN_CHECKS == 0 && std::chrono::steady_clock::now() >= deadline) {
+      stopped = true;
+    }
+  }
+}
+
+/*
+ * Counts a playout against the budget, fails once maxPlayouts are taken.
+ */
+bool Mcts::reservePlayout() {
+  unsigned long long current = playouts.load(std::memory_order_relaxed);
+  do {
+    if(config.maxPlayouts > 0 && current >= config.maxPlayouts) return false;
+  } while(!playouts.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+  return true;
+}
+
+/*
+ * One iteration: selection down the tree, expansion of the reached leaf, rollout and
+ * backpropagation. Actions are made on game and undone at the end.
+ * Statistics only need to be eventually consistent, so they're updated with relaxed atomics.
+ */
+void Mcts::playout(MctsWorker& worker, Game& game) {
+  std::vector<uint32_t>& path = worker.path;
+  std::vector<UndoInfo>& undoInfos = worker.undoInfos;
+  path.clear();
+  undoInfos.clear();
+  uint32_t current = 0;
+  path.push_back(current);
+  while(nodes[current].expanded()) {
+    current = selectChild(current);
+    descend(worker, game, current);
+  }
+  // leaves are expanded on their second visit, the root right away
+  if(!game.gameOver() && (current == 0 || nodes[current].visits.load(std::memory_order_relaxed) > 0) &&
+      expand(worker, game, current)) {
+    current = selectChild(current);
+    descend(worker, game, current);
+  }
+  float value = rollout(worker, game);
+
+  // undoing the path tells who played each action
+  for(int i = (int) path.size() - 1; i >= 1; i--) {
+    game.undoAction(undoInfos[i - 1]);
+    MctsNode& n = nodes[path[i]];
+    addValue(n.valueSum, game.currentPlayer == PLAYER_1 ? value : 1.0f - value);
+    n.visits.fetch_add(1, std::memory_order_relaxed);
+    n.virtualLosses.fetch_sub(1, std::memory_order_relaxed);
+  }
+  nodes[0].visits.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * Makes the action of a selected child, which counts as a loss until the playout is backed up.
+ */
+void Mcts::descend(MctsWorker& worker, Game& game, uint32_t nodeIndex) {
+  MctsNode& n = nodes[nodeIndex];
+  n.virtualLosses.fetch_add(1, std::memory_order_relaxed);
+  worker.undoInfos.push_back(game.makeAction(n.moveSrcIdx, n.moveDstIdx, n.abilitySrcIdx, n.abilityDstIdx));
+  worker.path.push_back(nodeIndex);
+}
+
+/*
+ * Adds a child for every useful legal action. Fails if the pool is full or another thread
+ * is expanding the node. Children are published with a release store once they are filled in.
+ */
+bool Mcts::expand(MctsWorker& worker, Game& game, uint32_t nodeIndex) {
+  MctsNode& n = nodes[nodeIndex];
+  uint64_t unexpanded = 0;
+  if(!n.children.compare_exchange_strong(unexpanded, CHILDREN_EXPANDING, std::memory_order_acquire)) return false;
+  game.usefulLegalActions(worker.actions);
+  uint32_t numActions = worker.actions.size();
+  uint32_t firstChild;
+  if(numActions == 0 || !allocateNodes(numActions, firstChild)) {
+    // a later playout may find free nodes
+    n.children.store(0, std::memory_order_release);
+    return false;
+  }
+  if(config.selectionPolicy == PUCT && config.priorFunction) {
+    config.priorFunction(game, worker.actions, worker.priors.data());
+  } else {
+    for(uint32_t i = 0; i < numActions; i++) {
+      worker.priors[i] = 1.0f / numActions;
+    }
+  }
+  for(uint32_t i = 0; i < numActions; i++) {
+    nodes[firstChild + i].reset(worker.actions[i], worker.priors[i]);
+  }
+  n.children.store(((uint64_t) numActions << 32) | firstChild, std::memory_order_release);
+  return true;
+}
+
+/*
+ * Takes count consecutive nodes from the pool: a freed block of the same size, else unused
+ * nodes, else the front of a bigger freed block whose rest is freed again.
+ */
+bool Mcts::allocateNodes(uint32_t count, uint32_t& first) {
+  if(popFreeBlock(count, first)) return true;
+  uint32_t current = nextFreeNode.load(std::memory_order_relaxed);
+  while(nodes.size() - current >= count) {
+    if(nextFreeNode.compare_exchange_weak(current, current + count, std::memory_order_relaxed)) {
+      first = current;
+      return true;
+    }
+  }
+  if(numFreeNodes.load(std::memory_order_relaxed) < count) return false;
+  for(uint32_t size = count + 1; size < freeBlocks.size(); size++) {
+    if(popFreeBlock(size, first)) {
+      pushFreeBlock(first + count, size - count);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Lock-free stack pop. Allocated blocks are only freed between searches and split remainders
+ * start inside a free block, so a popped block can't be pushed again during the search and
+ * the lists don't suffer from ABA.
+ */
+bool Mcts::popFreeBlock(uint32_t count, uint32_t& first) {
+  std::atomic<uint32_t>& head = freeBlocks[count];
+  uint32_t block = head.load(std::memory_order_acquire);
+  while(block != NO_NODE) {
+    uint32_t next = (uint32_t) nodes[block].children.load(std::memory_order_relaxed);
+    if(head.compare_exchange_weak(block, next, std::memory_order_acquire)) {
+      numFreeNodes.fetch_sub(count, std::memory_order_relaxed);
+      first = block;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Lock-free stack push, the link to the next block is kept in the children of the first node.
+ */
+void Mcts::pushFreeBlock(uint32_t first, uint32_t count) {
+  std::atomic<uint32_t>& head = freeBlocks[count];
+  uint32_t next = head.load(std::memory_order_relaxed);
+  do {
+    nodes[first].children.store(next, std::memory_order_relaxed);
+  } while(!head.compare_exchange_weak(next, first, std::memory_order_release, std::memory_order_relaxed));
+  numFreeNodes.fetch_add(count, std::memory_order_relaxed);
+}
+
+/*
+ * Frees the child blocks below nodeIndex, but not nodeIndex itself.
+ */
+void Mcts::freeSubtree(uint32_t nodeIndex) {
+  const MctsNode& n = nodes[nodeIndex];
+  if(!n.expanded()) return;
+  uint32_t firstChild = n.firstChild();
+  uint32_t numChildren = n.numChildren();
+  for(uint32_t i = firstChild; i < firstChild + numChildren; i++) {
+    freeSubtree(i);
+  }
+  pushFreeBlock(firstChild, numChildren);
+}
+
+/*
+ * Playouts in progress count as visits with value 0, which steers other threads to
+ * different children.
+ */
+uint32_t Mcts::selectChild(uint32_t nodeIndex) const {
+  const MctsNode& n = nodes[nodeIndex];
+  uint32_t firstChild = n.firstChild();
+  uint32_t numChildren = n.numChildren();
+  uint32_t parentVisits = n.visits.load(std::memory_order_relaxed);
+  double c = config.explorationConstant;
+  double logVisits = std::log((double) std::max(parentVisits, 1u));
+  double sqrtVisits = std::sqrt((double) parentVisits);
+  uint32_t best = firstChild;
+  double bestScore = -1;
+  for(uint32_t i = firstChild; i < firstChild + numChildren; i++) {
+    const MctsNode& child = nodes[i];
+    uint32_t visits = child.visits.load(std::memory_order_relaxed) + child.virtualLosses.load(std::memory_order_relaxed);
+    float valueSum = child.valueSum.load(std::memory_order_relaxed);
+    double score;
+    if(config.selectionPolicy == UCT) {
+      // every child is tried once first
+      if(visits == 0) return i;
+      score = valueSum / visits + c * std::sqrt(logVisits / visits);
+    } else {
+      double q = visits > 0 ? valueSum / visits : FIRST_PLAY_VALUE;
+      score = q + c * child.prior * sqrtVisits / (1 + visits);
+    }
+    if(score > bestScore) {
+      bestScore = score;
+      best = i;
+    }
+  }
+  return best;
+}
+
+/*
+ * Plays random actions until the game is over or maxRolloutPlies is reached,
+ * undoes them and returns the result for player 1.
+ */
+float Mcts::rollout(MctsWorker& worker, Game& game) {
+  std::vector<UndoInfo>& undoInfos = worker.undoInfos;
+  size_t treeDepth = undoInfos.size();
+  int plies = 0;
+  while(!game.gameOver() && plies < config.maxRolloutPlies) {
+    PlayerAction pa = randomAction(worker, game);
+    undoInfos.push_back(game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx));
+    plies++;
+  }
+  float value;
+  if(game.gameOver()) {
+    value = game.winner() == PLAYER_1 ? 1.0f : 0.0f;
+  } else {
+    value = healthPointsValue(game);
+  }
+  while(undoInfos.size() > treeDepth) {
+    game.undoAction(undoInfos.back());
+    undoInfos.pop_back();
+  }
+  return value;
+}
+
+/*
+ * Picks a random legal move (or move skip), then a random useful ability available after it
+ * (or ability skip, unless the policy prefers abilities). Only moves and abilities are
+ * listed, never their combinations.
+ */
+PlayerAction Mcts::randomAction(MctsWorker& worker, const Game& game) {
+  PlayerMove moves[MAX_NUM_MOVES];
+  int movingSlots[MAX_NUM_MOVES];
+  int numMoves = 0;
+  Player currentPlayer = game.currentPlayer;
+  for(int slot = 0; slot < NUM_STARTING_PIECES; slot++) {
+    const Piece* piece = game.playerPiece(currentPlayer, slot);
+    if(piece->healthPoints <= 0) continue; // dead pieces don't move
+    for(PlayerMove move: game.gameCache->legalMoves(piece->type, piece->squareIndex)) {
+      if(!isMoveLegal(game, piece, move.moveDstIdx)) continue;
+      moves[numMoves] = move;
+      movingSlots[numMoves] = slot;
+      numMoves++;
+    }
+  }
+  // numMoves means move skip
+  int moveChoice = worker.rng() % (numMoves + 1);
+  PlayerMove move = moveChoice < numMoves ? moves[moveChoice] : PlayerMove(MOVE_SKIP, MOVE_SKIP);
+  int movingSlot = moveChoice < numMoves ? movingSlots[moveChoice] : -1;
+
+  PlayerAbility abilities[NUM_STARTING_PIECES * NUM_STARTING_PIECES];
+  int numAbilities = 0;
+  for(int slot = 0; slot < NUM_STARTING_PIECES; slot++) {
+    const Piece* piece = game.playerPiece(currentPlayer, slot);
+    if(piece->healthPoints <= 0) continue; // no abilities for dead pieces
+    int abilitySrcIdx = slot == movingSlot ? move.moveDstIdx : piece->squareIndex;
+    numAbilities += usefulAbilities(game, piece, abilitySrcIdx, &abilities[numAbilities]);
+  }
+  int numChoices = numAbilities + 1; // numAbilities means ability skip
+  if(config.rolloutPolicy == ABILITY_FIRST_ROLLOUT && numAbilities > 0) {
+    numChoices = numAbilities;
+  }
+  int abilityChoice = worker.rng() % numChoices;
+  if(abilityChoice < numAbilities) {
+    return PlayerAction(move.moveSrcIdx, move.moveDstIdx, abilities[abilityChoice].abilitySrcIdx, abilities[abilityChoice].abilityDstIdx);
+  }
+  return PlayerAction(move.moveSrcIdx, move.moveDstIdx, ABILITY_SKIP, ABILITY_SKIP);
+}
+
+/*
+ * Most visited child of the root.
+ */
+uint32_t Mcts::bestChild() const {
+  const MctsNode& n = nodes[0];
+  uint32_t firstChild = n.firstChild();
+  uint32_t best = firstChild;
+  for(uint32_t i = firstChild; i < firstChild + n.numChildren(); i++) {
+    if(nodes[i].visits > nodes[best].visits) best = i;
+  }
+  return best;
+}
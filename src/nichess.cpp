@@ -1,6 +1,9 @@
 #include "nichess/nichess.hpp"
+#include "nichess/bitboard.hpp"
 #include "nichess/util.hpp"
 
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -23,39 +26,6 @@ std::tuple<int, int> nichess::boardIndexToCoordinates(int squareIndex) {
   return std::tuple<int, int>(x, y);
 }
 
-PlayerAction::PlayerAction() { }
-
-PlayerAction::PlayerAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
-  this->moveSrcIdx = moveSrcIdx;
-  this->moveDstIdx = moveDstIdx;
-  this->abilitySrcIdx = abilitySrcIdx;
-  this->abilityDstIdx = abilityDstIdx;
-}
-
-PlayerMove::PlayerMove() { }
-
-PlayerMove::PlayerMove(int moveSrcIdx, int moveDstIdx) {
-  this->moveSrcIdx = moveSrcIdx;
-  this->moveDstIdx = moveDstIdx;
-}
-
-PlayerAbility::PlayerAbility() { }
-
-PlayerAbility::PlayerAbility(int abilitySrcIdx, int abilityDstIdx) {
-  this->abilitySrcIdx = abilitySrcIdx;
-  this->abilityDstIdx = abilityDstIdx;
-}
-
-Piece::Piece(): type(PieceType::NO_PIECE), healthPoints(0), squareIndex(0) { }
-
-Piece::Piece(PieceType type, int healthPoints, int squareIndex):
-  type(type),
-  healthPoints(healthPoints),
-  squareIndex(squareIndex)
-{ }
-
-Piece::Piece(const Piece& other): type(other.type), healthPoints(other.healthPoints), squareIndex(other.squareIndex) { }
-
 bool Piece::operator==(const Piece& other) const {
   const auto* other_cs = dynamic_cast<const Piece*>(&other);
   if (other_cs == nullptr) {
@@ -72,120 +42,82 @@ bool Piece::operator!=(const Piece& other) const {
   return (other_cs->type != type || other_cs->healthPoints != healthPoints || other_cs->squareIndex != squareIndex);
 }
 
-UndoInfo::UndoInfo() {
-  for(int i = 0; i < 9; i++) {
-    this->affectedPieces[i] = nullptr;
-  }
+UndoInfo::UndoInfo():
+  moveSrcIdx(MOVE_SKIP),
+  moveDstIdx(MOVE_SKIP),
+  abilityType(NO_ABILITY),
+  affectedSlots(0),
+  killedSlots(0)
+{ }
+
+UndoInfo::UndoInfo(int moveSrcIdx, int moveDstIdx, AbilityType abilityType):
+  moveSrcIdx((int8_t) moveSrcIdx),
+  moveDstIdx((int8_t) moveDstIdx),
+  abilityType(abilityType),
+  affectedSlots(0),
+  killedSlots(0)
+{ }
+
+ActionStack::ActionStack(int maxPly): lists(maxPly + 1) { }
+
+ActionList& ActionStack::at(int ply) {
+  return lists[ply];
 }
 
-UndoInfo::UndoInfo(int moveSrcIdx, int moveDstIdx, AbilityType abilityType) {
-  this->moveSrcIdx = moveSrcIdx;
-  this->moveDstIdx = moveDstIdx;
-  this->abilityType = abilityType;
-  for(int i = 0; i < 9; i++) {
-    this->affectedPieces[i] = nullptr;
-  }
+int ActionStack::maxPly() const {
+  return (int) lists.size() - 1;
 }
 
-GameCache::GameCache() {
-  pieceTypeToSquareIndexToLegalMoves = generateLegalMovesOnAnEmptyBoard();
-  pieceTypeToSquareIndexToLegalAbilities = generateLegalAbilitiesOnAnEmptyBoard();
-  squareToNeighboringSquares = generateSquareToNeighboringSquares();
+/*
+ * Rebuilds squareSlots, hash, occupancy and accumulators from the pieces array.
+ */
+void Game::placePieces() {
+  for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+    pieces[NUM_PLAYERS][i] = Piece();
+  }
+  for(int i = 0; i < NUM_SQUARES; i++) {
+    squareSlots[i] = EMPTY_SLOT;
+  }
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      if(pieces[p][i].healthPoints > 0) {
+        squareSlots[pieces[p][i].squareIndex] = (uint8_t) (p * NUM_STARTING_PIECES + i);
+      }
+    }
+  }
+  zobristKey = computeHash();
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    occupancy[p] = 0;
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      if(pieces[p][i].healthPoints > 0) {
+        occupancy[p] |= squareMask(pieces[p][i].squareIndex);
+      }
+    }
+  }
+  accumulatorValues = computeAccumulators();
 }
 
 void Game::reset() {
   moveNumber = 0;
   currentPlayer = Player::PLAYER_1;
   // Create starting position
-  board[coordinatesToBoardIndex(0,0)] = new Piece(PieceType::P1_KING, KING_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,0));
-  board[coordinatesToBoardIndex(0,1)] = new Piece(PieceType::P1_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,1));
-  board[coordinatesToBoardIndex(1,1)] = new Piece(PieceType::P1_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(1,1));
-  board[coordinatesToBoardIndex(7,0)] = new Piece(PieceType::P1_ASSASSIN, ASSASSIN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,0));
-  board[coordinatesToBoardIndex(3,1)] = new Piece(PieceType::P1_WARRIOR, WARRIOR_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(3,1));
-  board[coordinatesToBoardIndex(4,1)] = new Piece(PieceType::P1_MAGE, MAGE_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(4,1));
-  board[coordinatesToBoardIndex(5,1)] = new Piece(PieceType::P1_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(5,1));
-
-  board[coordinatesToBoardIndex(7,7)] = new Piece(PieceType::P2_KING, KING_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,7));
-  board[coordinatesToBoardIndex(7,6)] = new Piece(PieceType::P2_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,6));
-  board[coordinatesToBoardIndex(6,6)] = new Piece(PieceType::P2_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(6,6));
-  board[coordinatesToBoardIndex(0,7)] = new Piece(PieceType::P2_ASSASSIN, ASSASSIN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,7));
-  board[coordinatesToBoardIndex(4,6)] = new Piece(PieceType::P2_WARRIOR, WARRIOR_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(4,6));
-  board[coordinatesToBoardIndex(3,6)] = new Piece(PieceType::P2_MAGE, MAGE_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(3,6));
-  board[coordinatesToBoardIndex(2,6)] = new Piece(PieceType::P2_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(2,6));
-
-  board[coordinatesToBoardIndex(0,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(0,2));
-  board[coordinatesToBoardIndex(0,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(0,3));
-  board[coordinatesToBoardIndex(0,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(0,4));
-  board[coordinatesToBoardIndex(0,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(0,5));
-  board[coordinatesToBoardIndex(0,6)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(0,6));
-  board[coordinatesToBoardIndex(1,0)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,0));
-  board[coordinatesToBoardIndex(1,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,2));
-  board[coordinatesToBoardIndex(1,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,3));
-  board[coordinatesToBoardIndex(1,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,4));
-  board[coordinatesToBoardIndex(1,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,5));
-  board[coordinatesToBoardIndex(1,6)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,6));
-  board[coordinatesToBoardIndex(1,7)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(1,7));
-  board[coordinatesToBoardIndex(2,0)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,0));
-  board[coordinatesToBoardIndex(2,1)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,1));
-  board[coordinatesToBoardIndex(2,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,2));
-  board[coordinatesToBoardIndex(2,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,3));
-  board[coordinatesToBoardIndex(2,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,4));
-  board[coordinatesToBoardIndex(2,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,5));
-  board[coordinatesToBoardIndex(2,7)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(2,7));
-  board[coordinatesToBoardIndex(3,0)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(3,0));
-  board[coordinatesToBoardIndex(3,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(3,2));
-  board[coordinatesToBoardIndex(3,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(3,3));
-  board[coordinatesToBoardIndex(3,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(3,4));
-  board[coordinatesToBoardIndex(3,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(3,5));
-  board[coordinatesToBoardIndex(3,7)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(3,7));
-  board[coordinatesToBoardIndex(4,0)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(4,0));
-  board[coordinatesToBoardIndex(4,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(4,2));
-  board[coordinatesToBoardIndex(4,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(4,3));
-  board[coordinatesToBoardIndex(4,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(4,4));
-  board[coordinatesToBoardIndex(4,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(4,5));
-  board[coordinatesToBoardIndex(4,7)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(4,7));
-  board[coordinatesToBoardIndex(5,0)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,0));
-  board[coordinatesToBoardIndex(5,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,2));
-  board[coordinatesToBoardIndex(5,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,3));
-  board[coordinatesToBoardIndex(5,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,4));
-  board[coordinatesToBoardIndex(5,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,5));
-  board[coordinatesToBoardIndex(5,6)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,6));
-  board[coordinatesToBoardIndex(5,7)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(5,7));
-  board[coordinatesToBoardIndex(6,0)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,0));
-  board[coordinatesToBoardIndex(6,1)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,1));
-  board[coordinatesToBoardIndex(6,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,2));
-  board[coordinatesToBoardIndex(6,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,3));
-  board[coordinatesToBoardIndex(6,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,4));
-  board[coordinatesToBoardIndex(6,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,5));
-  board[coordinatesToBoardIndex(6,7)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(6,7));
-  board[coordinatesToBoardIndex(7,1)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(7,1));
-  board[coordinatesToBoardIndex(7,2)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(7,2));
-  board[coordinatesToBoardIndex(7,3)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(7,3));
-  board[coordinatesToBoardIndex(7,4)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(7,4));
-  board[coordinatesToBoardIndex(7,5)] = new Piece(PieceType::NO_PIECE, 0, coordinatesToBoardIndex(7,5));
-
-  // Piece pointers are also kept in an array for faster access
-  std::vector<Piece*> p1Pieces{NUM_STARTING_PIECES};
-  p1Pieces[KING_PIECE_INDEX] = board[coordinatesToBoardIndex(0,0)];
-  p1Pieces[PAWN_1_PIECE_INDEX] = board[coordinatesToBoardIndex(0,1)];
-  p1Pieces[PAWN_2_PIECE_INDEX] = board[coordinatesToBoardIndex(1,1)];
-  p1Pieces[ASSASSIN_PIECE_INDEX] = board[coordinatesToBoardIndex(7,0)];
-  p1Pieces[WARRIOR_PIECE_INDEX] = board[coordinatesToBoardIndex(3,1)];
-  p1Pieces[MAGE_PIECE_INDEX] = board[coordinatesToBoardIndex(4,1)];
-  p1Pieces[PAWN_3_PIECE_INDEX] = board[coordinatesToBoardIndex(5,1)];
-  playerToPieces[Player::PLAYER_1] = p1Pieces;
-  p1King = p1Pieces[KING_PIECE_INDEX];
-
-  std::vector<Piece*> p2Pieces{NUM_STARTING_PIECES};
-  p2Pieces[KING_PIECE_INDEX] = board[coordinatesToBoardIndex(7,7)];
-  p2Pieces[PAWN_1_PIECE_INDEX] = board[coordinatesToBoardIndex(7,6)];
-  p2Pieces[PAWN_2_PIECE_INDEX] = board[coordinatesToBoardIndex(6,6)];
-  p2Pieces[ASSASSIN_PIECE_INDEX] = board[coordinatesToBoardIndex(0,7)];
-  p2Pieces[WARRIOR_PIECE_INDEX] = board[coordinatesToBoardIndex(4,6)];
-  p2Pieces[MAGE_PIECE_INDEX] = board[coordinatesToBoardIndex(3,6)];
-  p2Pieces[PAWN_3_PIECE_INDEX] = board[coordinatesToBoardIndex(2,6)];
-  playerToPieces[Player::PLAYER_2] = p2Pieces;
-  p2King = p2Pieces[KING_PIECE_INDEX];
+  pieces[PLAYER_1][KING_PIECE_INDEX] = Piece(PieceType::P1_KING, KING_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,0));
+  pieces[PLAYER_1][PAWN_1_PIECE_INDEX] = Piece(PieceType::P1_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,1));
+  pieces[PLAYER_1][PAWN_2_PIECE_INDEX] = Piece(PieceType::P1_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(1,1));
+  pieces[PLAYER_1][ASSASSIN_PIECE_INDEX] = Piece(PieceType::P1_ASSASSIN, ASSASSIN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,0));
+  pieces[PLAYER_1][WARRIOR_PIECE_INDEX] = Piece(PieceType::P1_WARRIOR, WARRIOR_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(3,1));
+  pieces[PLAYER_1][MAGE_PIECE_INDEX] = Piece(PieceType::P1_MAGE, MAGE_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(4,1));
+  pieces[PLAYER_1][PAWN_3_PIECE_INDEX] = Piece(PieceType::P1_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(5,1));
+
+  pieces[PLAYER_2][KING_PIECE_INDEX] = Piece(PieceType::P2_KING, KING_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,7));
+  pieces[PLAYER_2][PAWN_1_PIECE_INDEX] = Piece(PieceType::P2_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(7,6));
+  pieces[PLAYER_2][PAWN_2_PIECE_INDEX] = Piece(PieceType::P2_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(6,6));
+  pieces[PLAYER_2][ASSASSIN_PIECE_INDEX] = Piece(PieceType::P2_ASSASSIN, ASSASSIN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(0,7));
+  pieces[PLAYER_2][WARRIOR_PIECE_INDEX] = Piece(PieceType::P2_WARRIOR, WARRIOR_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(4,6));
+  pieces[PLAYER_2][MAGE_PIECE_INDEX] = Piece(PieceType::P2_MAGE, MAGE_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(3,6));
+  pieces[PLAYER_2][PAWN_3_PIECE_INDEX] = Piece(PieceType::P2_PAWN, PAWN_STARTING_HEALTH_POINTS, coordinatesToBoardIndex(2,6));
+
+  placePieces();
 }
 
 Game::Game(GameCache& gameCache) {
@@ -193,374 +125,259 @@ Game::Game(GameCache& gameCache) {
   reset();
 }
 
-Game::Game(const Game& other) {
-  this->moveNumber = other.moveNumber;
-  this->currentPlayer = other.currentPlayer;
-  this->gameCache = other.gameCache;
-  for(int i = 0; i < NUM_SQUARES; i++) {
-    board[i] = new Piece(*other.board[i]);
-  }
-
-  std::vector<Piece*> otherP1Pieces = other.playerToPieces[PLAYER_1];
-  std::vector<Piece*> otherP2Pieces = other.playerToPieces[PLAYER_2];
-  std::vector<Piece*> p1Pieces{NUM_STARTING_PIECES};
-
-  Piece* otherP1King = otherP1Pieces[KING_PIECE_INDEX];
-  if(otherP1King->healthPoints > 0) {
-    p1Pieces[KING_PIECE_INDEX] = board[otherP1King->squareIndex];
-  } else {
-    p1Pieces[KING_PIECE_INDEX] = new Piece(PieceType::P1_KING, otherP1King->healthPoints, otherP1King->squareIndex);
-  }
-  p1King = p1Pieces[KING_PIECE_INDEX];
+Game::Game(GameCache& gameCache, const std::string encodedBoard) {
+  this->gameCache = &gameCache;
+  boardFromString(encodedBoard);
+}
 
-  Piece* otherP1Pawn1 = otherP1Pieces[PAWN_1_PIECE_INDEX];
-  if(otherP1Pawn1->healthPoints > 0) {
-    p1Pieces[PAWN_1_PIECE_INDEX] = board[otherP1Pawn1->squareIndex];
-  } else {
-    p1Pieces[PAWN_1_PIECE_INDEX] = new Piece(PieceType::P1_PAWN, otherP1Pawn1->healthPoints, otherP1Pawn1->squareIndex);
+/*
+ * Assumes that the move and ability are legal.
+ * If the ability is not useful (i.e. does not alter the game state), it's converted to
+ * AbilityType::NO_ABILITY.
+ * Checking whether ability is useful makes the function ~1.5% slower.
+ */
+UndoInfo Game::makeAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
+  if(currentPlayer == PLAYER_1) {
+    return makeActionFor<PLAYER_1>(moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx);
   }
+  return makeActionFor<PLAYER_2>(moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx);
+}
 
-  Piece* otherP1Pawn2 = otherP1Pieces[PAWN_2_PIECE_INDEX];
-  if(otherP1Pawn2->healthPoints > 0) {
-    p1Pieces[PAWN_2_PIECE_INDEX] = board[otherP1Pawn2->squareIndex];
-  } else {
-    p1Pieces[PAWN_2_PIECE_INDEX] = new Piece(PieceType::P1_PAWN, otherP1Pawn2->healthPoints, otherP1Pawn2->squareIndex);
+/*
+ * makeAction for Us == currentPlayer. Abilities only do something to enemy pieces, so the
+ * side checks are a range comparison on the piece type.
+ */
+template<Player Us>
+UndoInfo Game::makeActionFor(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
+  constexpr Player Them = ~Us;
+  UndoInfo undoInfo = UndoInfo(moveSrcIdx, moveDstIdx, AbilityType::NO_ABILITY);
+  if(moveSrcIdx != MOVE_SKIP) {
+    makeMove(moveSrcIdx, moveDstIdx);
   }
-
-  Piece* otherP1Assassin = otherP1Pieces[ASSASSIN_PIECE_INDEX];
-  if(otherP1Assassin->healthPoints > 0) {
-    p1Pieces[ASSASSIN_PIECE_INDEX] = board[otherP1Assassin->squareIndex];
-  } else {
-    p1Pieces[ASSASSIN_PIECE_INDEX] = new Piece(PieceType::P1_ASSASSIN, otherP1Assassin->healthPoints, otherP1Assassin->squareIndex);
+  if(abilitySrcIdx != ABILITY_SKIP) {
+    AbilityEffect effect = abilityEffectTable.effects[pieceAt(abilitySrcIdx)->type][pieceAt(abilityDstIdx)->type];
+    if(effect.useful) {
+      undoInfo.abilityType = effect.abilityType;
+      // mage damages attacked piece and all enemy pieces that are touching it, the masks are
+      // taken before any of them dies
+      uint64_t targets = squareMask(abilityDstIdx);
+      if(effect.splash) {
+        targets |= gameCache->neighboringSquaresMask(abilityDstIdx) & occupancy[Them];
+      }
+      while(targets) {
+        damagePiece(pieceAt(popLsb(targets)), effect.damage, undoInfo);
+      }
+    }
   }
+  this->moveNumber += 1;
+  this->currentPlayer = Them;
+  zobristKey ^= zobristKeys.side;
+  return undoInfo;
+}
 
-  Piece* otherP1Warrior = otherP1Pieces[WARRIOR_PIECE_INDEX];
-  if(otherP1Warrior->healthPoints > 0) {
-    p1Pieces[WARRIOR_PIECE_INDEX] = board[otherP1Warrior->squareIndex];
+/*
+ * Reverts the last action, which must be the one undoInfo was made for.
+ */
+void Game::undoAction(UndoInfo undoInfo) {
+  if(currentPlayer == PLAYER_2) {
+    undoActionFor<PLAYER_1>(undoInfo);
   } else {
-    p1Pieces[WARRIOR_PIECE_INDEX] = new Piece(PieceType::P1_WARRIOR, otherP1Warrior->healthPoints, otherP1Warrior->squareIndex);
+    undoActionFor<PLAYER_2>(undoInfo);
   }
+}
 
-  Piece* otherP1Mage = otherP1Pieces[MAGE_PIECE_INDEX];
-  if(otherP1Mage->healthPoints > 0) {
-    p1Pieces[MAGE_PIECE_INDEX] = board[otherP1Mage->squareIndex];
-  } else {
-    p1Pieces[MAGE_PIECE_INDEX] = new Piece(PieceType::P1_MAGE, otherP1Mage->healthPoints, otherP1Mage->squareIndex);
+/*
+ * undoAction for Us == the player who made the action.
+ */
+template<Player Us>
+void Game::undoActionFor(const UndoInfo& undoInfo) {
+  constexpr Player Them = ~Us;
+  // undo ability, damaged pieces belong to the player to move
+  int abilityPoints = abilityTypeToAbilityPoints[undoInfo.abilityType];
+  for(uint64_t slots = undoInfo.affectedSlots; slots != 0; ) {
+    int slot = popLsb(slots);
+    restorePiece(&pieces[Them][slot], abilityPoints, (undoInfo.killedSlots >> slot) & 1);
   }
-
-  Piece* otherP1Pawn3 = otherP1Pieces[PAWN_3_PIECE_INDEX];
-  if(otherP1Pawn3->healthPoints > 0) {
-    p1Pieces[PAWN_3_PIECE_INDEX] = board[otherP1Pawn3->squareIndex];
-  } else {
-    p1Pieces[PAWN_3_PIECE_INDEX] = new Piece(PieceType::P1_PAWN, otherP1Pawn3->healthPoints, otherP1Pawn3->squareIndex);
+  // undo move
+  if(undoInfo.moveSrcIdx != MOVE_SKIP) {
+    undoMove(undoInfo.moveSrcIdx, undoInfo.moveDstIdx);
   }
+  this->moveNumber -= 1;
+  this->currentPlayer = Us;
+  zobristKey ^= zobristKeys.side;
+}
 
-  playerToPieces[Player::PLAYER_1] = p1Pieces;
+GameHistory::GameHistory(): end(0), size(0) { }
 
-  std::vector<Piece*> p2Pieces{NUM_STARTING_PIECES};
+UndoInfo GameHistory::makeAction(Game& game, int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
+  UndoInfo undoInfo = game.makeAction(moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx);
+  actions[end] = undoInfo;
+  end = (end + 1) & (UNDO_HISTORY_LENGTH - 1);
+  size = std::min(size + 1, UNDO_HISTORY_LENGTH);
+  return undoInfo;
+}
 
-  Piece* otherP2King = otherP2Pieces[KING_PIECE_INDEX];
-  if(otherP2King->healthPoints > 0) {
-    p2Pieces[KING_PIECE_INDEX] = board[otherP2King->squareIndex];
-  } else {
-    p2Pieces[KING_PIECE_INDEX] = new Piece(PieceType::P2_KING, otherP2King->healthPoints, otherP2King->squareIndex);
-  }
-  p2King = p2Pieces[KING_PIECE_INDEX];
+/*
+ * Reverts the last recorded action on game, false if the history is empty.
+ */
+bool GameHistory::undo(Game& game) {
+  if(size == 0) return false;
+  end = (end - 1) & (UNDO_HISTORY_LENGTH - 1);
+  size--;
+  game.undoAction(actions[end]);
+  return true;
+}
 
-  Piece* otherP2Pawn1 = otherP2Pieces[PAWN_1_PIECE_INDEX];
-  if(otherP2Pawn1->healthPoints > 0) {
-    p2Pieces[PAWN_1_PIECE_INDEX] = board[otherP2Pawn1->squareIndex];
-  } else {
-    p2Pieces[PAWN_1_PIECE_INDEX] = new Piece(PieceType::P2_PAWN, otherP2Pawn1->healthPoints, otherP2Pawn1->squareIndex);
-  }
+int GameHistory::length() const {
+  return size;
+}
 
-  Piece* otherP2Pawn2 = otherP2Pieces[PAWN_2_PIECE_INDEX];
-  if(otherP2Pawn2->healthPoints > 0) {
-    p2Pieces[PAWN_2_PIECE_INDEX] = board[otherP2Pawn2->squareIndex];
-  } else {
-    p2Pieces[PAWN_2_PIECE_INDEX] = new Piece(PieceType::P2_PAWN, otherP2Pawn2->healthPoints, otherP2Pawn2->squareIndex);
-  }
+void GameHistory::clear() {
+  end = 0;
+  size = 0;
+}
 
-  Piece* otherP2Assassin = otherP2Pieces[ASSASSIN_PIECE_INDEX];
-  if(otherP2Assassin->healthPoints > 0) {
-    p2Pieces[ASSASSIN_PIECE_INDEX] = board[otherP2Assassin->squareIndex];
-  } else {
-    p2Pieces[ASSASSIN_PIECE_INDEX] = new Piece(PieceType::P2_ASSASSIN, otherP2Assassin->healthPoints, otherP2Assassin->squareIndex);
+/*
+ * Updates occupancy and king zones for a living piece going from srcIdx to dstIdx.
+ */
+void Game::relocatePiece(Piece* piece, int srcIdx, int dstIdx) {
+  int slot = piece - &pieces[0][0];
+  Player owner = Player(slot / NUM_STARTING_PIECES);
+  Player enemy = ~owner;
+  occupancy[owner] ^= squareMask(srcIdx) | squareMask(dstIdx);
+  uint64_t enemyKingZone = gameCache->neighboringSquaresMask(pieces[enemy][KING_PIECE_INDEX].squareIndex);
+  accumulatorValues.kingZonePieces[enemy] += (int) ((enemyKingZone >> dstIdx) & 1) - (int) ((enemyKingZone >> srcIdx) & 1);
+  if(slot % NUM_STARTING_PIECES == KING_PIECE_INDEX) {
+    accumulatorValues.kingZonePieces[owner] = popCount(gameCache->neighboringSquaresMask(dstIdx) & occupancy[enemy]);
   }
+}
 
-  Piece* otherP2Warrior = otherP2Pieces[WARRIOR_PIECE_INDEX];
-  if(otherP2Warrior->healthPoints > 0) {
-    p2Pieces[WARRIOR_PIECE_INDEX] = board[otherP2Warrior->squareIndex];
+/*
+ * Applies ability damage to the piece and removes it from the board if it dies.
+ */
+void Game::damagePiece(Piece* piece, int abilityPoints, UndoInfo& undoInfo) {
+  int slot = piece - &pieces[0][0];
+  Player owner = Player(slot / NUM_STARTING_PIECES);
+  uint8_t slotBit = (uint8_t) (1 << (slot % NUM_STARTING_PIECES));
+  undoInfo.affectedSlots |= slotBit;
+  zobristKey ^= zobristHealthPointsKey(slot, piece->healthPoints);
+  if(piece->healthPoints > abilityPoints) {
+    piece->healthPoints -= abilityPoints;
+    accumulatorValues.healthPoints[owner] -= abilityPoints;
+    zobristKey ^= zobristHealthPointsKey(slot, piece->healthPoints);
   } else {
-    p2Pieces[WARRIOR_PIECE_INDEX] = new Piece(PieceType::P2_WARRIOR, otherP2Warrior->healthPoints, otherP2Warrior->squareIndex);
+    undoInfo.killedSlots |= slotBit;
+    accumulatorValues.healthPoints[owner] -= piece->healthPoints;
+    accumulatorValues.material[owner] -= pieceTypeToValue[piece->type];
+    uint64_t mask = squareMask(piece->squareIndex);
+    occupancy[owner] &= ~mask;
+    if(gameCache->neighboringSquaresMask(pieces[~owner][KING_PIECE_INDEX].squareIndex) & mask) {
+      accumulatorValues.kingZonePieces[~owner]--;
+    }
+    piece->healthPoints -= abilityPoints;
+    zobristKey ^= zobristKeys.pieceSquare[piece->type][piece->squareIndex];
+    squareSlots[piece->squareIndex] = EMPTY_SLOT;
   }
+}
 
-  Piece* otherP2Mage = otherP2Pieces[MAGE_PIECE_INDEX];
-  if(otherP2Mage->healthPoints > 0) {
-    p2Pieces[MAGE_PIECE_INDEX] = board[otherP2Mage->squareIndex];
+/*
+ * Reverts damagePiece, putting the piece back on the board if it was killed (killedSlots of
+ * the undo record).
+ */
+void Game::restorePiece(Piece* piece, int abilityPoints, bool killed) {
+  int slot = piece - &pieces[0][0];
+  Player owner = Player(slot / NUM_STARTING_PIECES);
+  if(!killed) {
+    zobristKey ^= zobristHealthPointsKey(slot, piece->healthPoints);
+    accumulatorValues.healthPoints[owner] += abilityPoints;
   } else {
-    p2Pieces[MAGE_PIECE_INDEX] = new Piece(PieceType::P2_MAGE, otherP2Mage->healthPoints, otherP2Mage->squareIndex);
+    zobristKey ^= zobristKeys.pieceSquare[piece->type][piece->squareIndex];
+    accumulatorValues.healthPoints[owner] += piece->healthPoints + abilityPoints;
+    accumulatorValues.material[owner] += pieceTypeToValue[piece->type];
+    uint64_t mask = squareMask(piece->squareIndex);
+    occupancy[owner] |= mask;
+    if(gameCache->neighboringSquaresMask(pieces[~owner][KING_PIECE_INDEX].squareIndex) & mask) {
+      accumulatorValues.kingZonePieces[~owner]++;
+    }
+    squareSlots[piece->squareIndex] = (uint8_t) slot;
   }
+  piece->healthPoints += abilityPoints;
+  zobristKey ^= zobristHealthPointsKey(slot, piece->healthPoints);
+}
 
-  Piece* otherP2Pawn3 = otherP2Pieces[PAWN_3_PIECE_INDEX];
-  if(otherP2Pawn3->healthPoints > 0) {
-    p2Pieces[PAWN_3_PIECE_INDEX] = board[otherP2Pawn3->squareIndex];
-  } else {
-    p2Pieces[PAWN_3_PIECE_INDEX] = new Piece(PieceType::P2_PAWN, otherP2Pawn3->healthPoints, otherP2Pawn3->squareIndex);
+/*
+ * Zobrist key of the position: piece types and squares, health points of every living piece
+ * (keyed by its slot) and the side to move. Move number is not included.
+ */
+uint64_t Game::computeHash() const {
+  uint64_t retval = currentPlayer == PLAYER_2 ? zobristKeys.side : 0;
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      const Piece& piece = pieces[p][i];
+      if(piece.healthPoints <= 0) continue;
+      retval ^= zobristKeys.pieceSquare[piece.type][piece.squareIndex];
+      retval ^= zobristHealthPointsKey(p * NUM_STARTING_PIECES + i, piece.healthPoints);
+    }
   }
-
-  playerToPieces[Player::PLAYER_2] = p2Pieces;
+  return retval;
 }
 
-Game::Game(GameCache& gameCache, const std::string encodedBoard) {
-  this->gameCache = &gameCache;
-  boardFromString(encodedBoard);
+/*
+ * Maintained incrementally by makeMove, makeAction and their undo counterparts.
+ */
+uint64_t Game::hash() const {
+  return zobristKey;
 }
 
-Game::~Game() {
-  for(Piece* p: playerToPieces[PLAYER_1]) {
-    if(p->healthPoints <= 0) delete p;
-  }
-  for(Piece* p: playerToPieces[PLAYER_2]) {
-    if(p->healthPoints <= 0) delete p;
+/*
+ * Accumulators computed by walking the pieces. King zones are counted around the king's square
+ * even if the king is dead.
+ */
+Accumulators Game::computeAccumulators() const {
+  Accumulators retval;
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    retval.healthPoints[p] = 0;
+    retval.material[p] = 0;
+    retval.kingZonePieces[p] = 0;
   }
-
-  for(int i = 0; i < NUM_SQUARES; i++) {
-    delete board[i];
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    uint64_t enemyKingZone = gameCache->neighboringSquaresMask(pieces[1 - p][KING_PIECE_INDEX].squareIndex);
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      const Piece& piece = pieces[p][i];
+      if(piece.healthPoints <= 0) continue;
+      retval.healthPoints[p] += piece.healthPoints;
+      retval.material[p] += pieceTypeToValue[piece.type];
+      if(enemyKingZone & squareMask(piece.squareIndex)) {
+        retval.kingZonePieces[1 - p]++;
+      }
+    }
   }
+  return retval;
 }
 
-
 /*
- * Assumes that the move and ability are legal.
- * If the ability is not useful (i.e. does not alter the game state), it's converted to
- * AbilityType::NO_ABILITY.
- * Checking whether ability is useful makes the function ~1.5% slower.
+ * Maintained incrementally like the hash.
  */
-UndoInfo Game::makeAction(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
-  UndoInfo undoInfo = UndoInfo();
-  undoInfo.moveSrcIdx = moveSrcIdx;
-  undoInfo.moveDstIdx = moveDstIdx;
-  if(moveSrcIdx != MOVE_SKIP) {
-    makeMove(moveSrcIdx, moveDstIdx);
-  }
-  if(abilitySrcIdx != ABILITY_SKIP) {
-    Piece* abilitySrcPiece = board[abilitySrcIdx];
-    Piece* abilityDstPiece = board[abilityDstIdx];
-    Piece* neighboringPiece;
-    int neighboringSquare;
-    switch(abilitySrcPiece->type) {
-      // king does single target damage
-      case P1_KING:
-        if(player1OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= KING_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::KING_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      // mage damages attacked piece and all enemy pieces that are touching it
-      case P1_MAGE:
-        if(player1OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= MAGE_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::MAGE_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        for(int i = 0; i < gameCache->squareToNeighboringSquares[abilityDstIdx].size(); i++) {
-          neighboringSquare = gameCache->squareToNeighboringSquares[abilityDstIdx][i];
-          neighboringPiece = board[neighboringSquare];
-          if(player1OrEmpty(neighboringPiece->type)) continue;  // don't damage your own pieces
-          neighboringPiece->healthPoints -= MAGE_ABILITY_POINTS;
-          // i+1 because 0 is for abilityDstPiece
-          undoInfo.affectedPieces[i+1] = neighboringPiece;
-          if(neighboringPiece->healthPoints <= 0) {
-            board[neighboringSquare] = new Piece(NO_PIECE, 0, neighboringSquare);
-          }
-        }
-        break;
-      case P1_PAWN:
-        if(player1OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= PAWN_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::PAWN_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      case P1_WARRIOR:
-        if(player1OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= WARRIOR_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::WARRIOR_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      case P1_ASSASSIN:
-        if(player1OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= ASSASSIN_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::ASSASSIN_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      case P2_KING:
-        if(player2OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= KING_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::KING_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      case P2_MAGE:
-        if(player2OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= MAGE_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::MAGE_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        for(int i = 0; i < gameCache->squareToNeighboringSquares[abilityDstIdx].size(); i++) {
-          neighboringSquare = gameCache->squareToNeighboringSquares[abilityDstIdx][i];
-          neighboringPiece = board[neighboringSquare];
-          if(player2OrEmpty(neighboringPiece->type)) continue;  // don't damage your own pieces
-          neighboringPiece->healthPoints -= MAGE_ABILITY_POINTS;
-          // i+1 because 0 is for abilityDstPiece
-          undoInfo.affectedPieces[i+1] = neighboringPiece;
-          if(neighboringPiece->healthPoints <= 0) {
-            board[neighboringSquare] = new Piece(NO_PIECE, 0, neighboringSquare);
-          }
-        }
-        break;
-      case P2_PAWN:
-        if(player2OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= PAWN_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::PAWN_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      case P2_WARRIOR:
-        if(player2OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= WARRIOR_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::WARRIOR_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-      case P2_ASSASSIN:
-        if(player2OrEmpty(abilityDstPiece->type)) {
-          undoInfo.abilityType = AbilityType::NO_ABILITY;
-          break;
-        }
-        abilityDstPiece->healthPoints -= ASSASSIN_ABILITY_POINTS;
-        undoInfo.abilityType = AbilityType::ASSASSIN_DAMAGE;
-        undoInfo.affectedPieces[0] = abilityDstPiece;
-        if(abilityDstPiece->healthPoints <= 0) {
-          board[abilityDstIdx] = new Piece(PieceType::NO_PIECE, 0, abilityDstIdx);
-        }
-        break;
-    }
-  } else {
-    undoInfo.abilityType = AbilityType::NO_ABILITY;
-  } 
-  this->moveNumber += 1;
-  this->currentPlayer = ~currentPlayer;
-  return undoInfo;
+const Accumulators& Game::accumulators() const {
+  return accumulatorValues;
 }
 
-void Game::undoAction(UndoInfo undoInfo) {
-  // undo ability
-  switch(undoInfo.abilityType) {
-    Piece* affectedPiece;
-    case KING_DAMAGE:
-      affectedPiece = undoInfo.affectedPieces[0];
-      affectedPiece->healthPoints += KING_ABILITY_POINTS;
-      if(this->board[affectedPiece->squareIndex]->type == PieceType::NO_PIECE) {
-        delete this->board[affectedPiece->squareIndex];
-      }
-      this->board[affectedPiece->squareIndex] = affectedPiece;
-      break;
-    case MAGE_DAMAGE:
-      for(int i = 0; i < 9; i++){ // 1 attacked square and 8 neighboring
-        affectedPiece = undoInfo.affectedPieces[i];
-        if(affectedPiece == nullptr) continue;
-        affectedPiece->healthPoints += MAGE_ABILITY_POINTS;
-        if(this->board[affectedPiece->squareIndex]->type == PieceType::NO_PIECE) {
-          delete this->board[affectedPiece->squareIndex];
-        }
-        this->board[affectedPiece->squareIndex] = affectedPiece;
-      }
-      break;
-    case WARRIOR_DAMAGE:
-      affectedPiece = undoInfo.affectedPieces[0];
-      affectedPiece->healthPoints += WARRIOR_ABILITY_POINTS;
-      if(this->board[affectedPiece->squareIndex]->type == PieceType::NO_PIECE) {
-        delete this->board[affectedPiece->squareIndex];
-      }
-      this->board[affectedPiece->squareIndex] = affectedPiece;
-      break;
-    case ASSASSIN_DAMAGE:
-      affectedPiece = undoInfo.affectedPieces[0];
-      affectedPiece->healthPoints += ASSASSIN_ABILITY_POINTS;
-      if(this->board[affectedPiece->squareIndex]->type == PieceType::NO_PIECE) {
-        delete this->board[affectedPiece->squareIndex];
-      }
-      this->board[affectedPiece->squareIndex] = affectedPiece;
-      break;
-    case PAWN_DAMAGE:
-      affectedPiece = undoInfo.affectedPieces[0];
-      affectedPiece->healthPoints += PAWN_ABILITY_POINTS;
-      if(this->board[affectedPiece->squareIndex]->type == PieceType::NO_PIECE) {
-        delete this->board[affectedPiece->squareIndex];
-      }
-      this->board[affectedPiece->squareIndex] = affectedPiece;
-      break;
-    case NO_ABILITY:
-      break;
-    default:
-      break;
-  }
-  // undo move
-  if(undoInfo.moveSrcIdx != MOVE_SKIP) {
-    undoMove(undoInfo.moveSrcIdx, undoInfo.moveDstIdx);
+uint64_t Game::playerOccupancy(Player player) const {
+  return occupancy[player];
+}
+
+bool Accumulators::operator==(const Accumulators& other) const {
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    if(healthPoints[p] != other.healthPoints[p] || material[p] != other.material[p] ||
+        kingZonePieces[p] != other.kingZonePieces[p]) {
+      return false;
+    }
   }
-  this->moveNumber -= 1;
-  this->currentPlayer = ~currentPlayer;
+  return true;
+}
+
+bool Accumulators::operator!=(const Accumulators& other) const {
+  return !(*this == other);
 }
 
 std::string Game::dump() const {
@@ -569,10 +386,10 @@ std::string Game::dump() const {
   for(int i = NUM_ROWS-1; i >= 0; i--) {
     retval += std::to_string(i) + std::string("   ");
     for(int j = 0; j < NUM_COLUMNS; j++) {
-      if(board[coordinatesToBoardIndex(j, i)]->type != PieceType::NO_PIECE) {
-        retval += pieceTypeToString(board[coordinatesToBoardIndex(j, i)]->type) + std::to_string(board[coordinatesToBoardIndex(j, i)]->healthPoints) + std::string(" ");
+      if(!isSquareEmpty(coordinatesToBoardIndex(j, i))) {
+        retval += pieceTypeToString(pieceAt(coordinatesToBoardIndex(j, i))->type) + std::to_string(pieceAt(coordinatesToBoardIndex(j, i))->healthPoints) + std::string(" ");
       } else {
-        retval += pieceTypeToString(board[coordinatesToBoardIndex(j, i)]->type) + std::string("   ") + std::string(" ");
+        retval += pieceTypeToString(pieceAt(coordinatesToBoardIndex(j, i))->type) + std::string("   ") + std::string(" ");
       }
     }
     retval += std::string("\n");
@@ -588,10 +405,12 @@ std::string Game::dump() const {
 }
 
 void Game::makeMove(int moveSrcIdx, int moveDstIdx) {
-  delete board[moveDstIdx];
-  board[moveDstIdx] = board[moveSrcIdx];
-  board[moveDstIdx]->squareIndex = moveDstIdx;
-  board[moveSrcIdx] = new Piece(PieceType::NO_PIECE, 0, moveSrcIdx);
+  Piece* piece = pieceAt(moveSrcIdx);
+  zobristKey ^= zobristKeys.pieceSquare[piece->type][moveSrcIdx] ^ zobristKeys.pieceSquare[piece->type][moveDstIdx];
+  relocatePiece(piece, moveSrcIdx, moveDstIdx);
+  squareSlots[moveDstIdx] = squareSlots[moveSrcIdx];
+  squareSlots[moveSrcIdx] = EMPTY_SLOT;
+  piece->squareIndex = moveDstIdx;
   return;
 }
 
@@ -599,26 +418,45 @@ void Game::makeMove(int moveSrcIdx, int moveDstIdx) {
  * Since move is being reverted, goal here is to move from "destination" to "source".
  */
 void Game::undoMove(int moveSrcIdx, int moveDstIdx) {
-  delete board[moveSrcIdx];
-  board[moveSrcIdx] = board[moveDstIdx];
-  board[moveSrcIdx]->squareIndex = moveSrcIdx;
-  board[moveDstIdx] = new Piece(PieceType::NO_PIECE, 0, moveDstIdx);
+  Piece* piece = pieceAt(moveDstIdx);
+  zobristKey ^= zobristKeys.pieceSquare[piece->type][moveSrcIdx] ^ zobristKeys.pieceSquare[piece->type][moveDstIdx];
+  relocatePiece(piece, moveDstIdx, moveSrcIdx);
+  squareSlots[moveSrcIdx] = squareSlots[moveDstIdx];
+  squareSlots[moveDstIdx] = EMPTY_SLOT;
+  piece->squareIndex = moveSrcIdx;
   return;
 }
 
+/*
+ * Is the piece one of Us's pawns trying to jump over another piece?
+ */
+template<Player Us>
+bool Game::pawnJumpBlocked(const Piece& piece, int moveDstIdx) const {
+  return piece.type == pawnType(Us) &&
+    moveDstIdx - piece.squareIndex == 2 * pawnForward(Us) &&
+    !isSquareEmpty(piece.squareIndex + pawnForward(Us));
+}
+
 /*
  * Assumes that the game is not over.
  */
 std::vector<PlayerMove> Game::legalMovesByPiece(int srcSquareIdx) {
+  if(currentPlayer == PLAYER_1) {
+    return legalMovesByPieceFor<PLAYER_1>(srcSquareIdx);
+  }
+  return legalMovesByPieceFor<PLAYER_2>(srcSquareIdx);
+}
+
+template<Player Us>
+std::vector<PlayerMove> Game::legalMovesByPieceFor(int srcSquareIdx) {
   std::vector<PlayerMove> retval;
-  Piece* piece = board[srcSquareIdx];
-  if((!pieceBelongsToPlayer(piece->type, currentPlayer)) ||
-      piece->healthPoints <= 0) {
+  Piece* piece = pieceAt(srcSquareIdx);
+  if(!isPieceOf<Us>(piece->type) || piece->healthPoints <= 0) {
     return retval;
   }
-  auto legalMovesOnEmptyBoard = gameCache->pieceTypeToSquareIndexToLegalMoves[piece->type][piece->squareIndex];
+  auto legalMovesOnEmptyBoard = gameCache->legalMoves(piece->type, piece->squareIndex);
   for(int i = 0; i < legalMovesOnEmptyBoard.size(); i++) {
-    if(board[legalMovesOnEmptyBoard[i].moveDstIdx]->type != NO_PIECE) continue;
+    if(!isSquareEmpty(legalMovesOnEmptyBoard[i].moveDstIdx)) continue;
     retval.push_back(legalMovesOnEmptyBoard[i]);
   }
   return retval;
@@ -630,313 +468,23 @@ std::vector<PlayerMove> Game::legalMovesByPiece(int srcSquareIdx) {
  * For example, warrior attacking an empty square is legal but doesn't change the game state.
  */
 std::vector<PlayerAbility> Game::usefulLegalAbilitiesByPiece(int srcSquareIdx) {
+  if(currentPlayer == PLAYER_1) {
+    return usefulLegalAbilitiesByPieceFor<PLAYER_1>(srcSquareIdx);
+  }
+  return usefulLegalAbilitiesByPieceFor<PLAYER_2>(srcSquareIdx);
+}
+
+template<Player Us>
+std::vector<PlayerAbility> Game::usefulLegalAbilitiesByPieceFor(int srcSquareIdx) {
   std::vector<PlayerAbility> retval;
-  Piece* piece = board[srcSquareIdx];
-  if((!pieceBelongsToPlayer(piece->type, currentPlayer)) ||
-      piece->healthPoints <= 0) {
+  Piece* piece = pieceAt(srcSquareIdx);
+  if(!isPieceOf<Us>(piece->type) || piece->healthPoints <= 0) {
     return retval;
   }
-  auto legalAbilitiesOnEmptyBoard = gameCache->pieceTypeToSquareIndexToLegalAbilities[piece->type][piece->squareIndex];
-  for(int l = 0; l < legalAbilitiesOnEmptyBoard.size(); l++) {
-    PlayerAbility currentAbility = legalAbilitiesOnEmptyBoard[l];
-    Piece* destinationSquarePiece = board[currentAbility.abilityDstIdx];
-    // exclude useless abilities, e.g. warrior attacking empty square
-    switch(piece->type) {
-      // king can only use abilities on enemy pieces
-      case P1_KING:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            continue;
-          case P1_MAGE:
-            continue;
-          case P1_PAWN:
-            continue;
-          case P1_WARRIOR:
-            continue;
-          case P1_ASSASSIN:
-            continue;
-          case P2_KING:
-            break;
-          case P2_MAGE:
-            break;
-          case P2_PAWN:
-            break;
-          case P2_WARRIOR:
-            break;
-          case P2_ASSASSIN:
-            break;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-      // mage can only use abilities on enemy pieces
-      case P1_MAGE:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            continue;
-          case P1_MAGE:
-            continue;
-          case P1_PAWN:
-            continue;
-          case P1_WARRIOR:
-            continue;
-          case P1_ASSASSIN:
-            continue;
-          case P2_KING:
-            break;
-          case P2_MAGE:
-            break;
-          case P2_PAWN:
-            break;
-          case P2_WARRIOR:
-            break;
-          case P2_ASSASSIN:
-            break;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      // pawn can only use abilities on enemy pieces
-      case P1_PAWN:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            continue;
-          case P1_MAGE:
-            continue;
-          case P1_PAWN:
-            continue;
-          case P1_WARRIOR:
-            continue;
-          case P1_ASSASSIN:
-            continue;
-          case P2_KING:
-            break;
-          case P2_MAGE:
-            break;
-          case P2_PAWN:
-            break;
-          case P2_WARRIOR:
-            break;
-          case P2_ASSASSIN:
-            break;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      // warrior can only use abilities on enemy pieces
-      case P1_WARRIOR:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            continue;
-          case P1_MAGE:
-            continue;
-          case P1_PAWN:
-            continue;
-          case P1_WARRIOR:
-            continue;
-          case P1_ASSASSIN:
-            continue;
-          case P2_KING:
-            break;
-          case P2_MAGE:
-            break;
-          case P2_PAWN:
-            break;
-          case P2_WARRIOR:
-            break;
-          case P2_ASSASSIN:
-            break;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      // assassin can only use abilities on enemy pieces
-      case P1_ASSASSIN:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            continue;
-          case P1_MAGE:
-            continue;
-          case P1_PAWN:
-            continue;
-          case P1_WARRIOR:
-            continue;
-          case P1_ASSASSIN:
-            continue;
-          case P2_KING:
-            break;
-          case P2_MAGE:
-            break;
-          case P2_PAWN:
-            break;
-          case P2_WARRIOR:
-            break;
-          case P2_ASSASSIN:
-            break;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-
-      // king can only use abilities on enemy pieces
-      case P2_KING:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            break;
-          case P1_MAGE:
-            break;
-          case P1_PAWN:
-            break;
-          case P1_WARRIOR:
-            break;
-          case P1_ASSASSIN:
-            break;
-          case P2_KING:
-            continue;
-          case P2_MAGE:
-            continue;
-          case P2_PAWN:
-            continue;
-          case P2_WARRIOR:
-            continue;
-          case P2_ASSASSIN:
-            continue;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-      // mage can only use abilities on enemy pieces
-      case P2_MAGE:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            break;
-          case P1_MAGE:
-            break;
-          case P1_PAWN:
-            break;
-          case P1_WARRIOR:
-            break;
-          case P1_ASSASSIN:
-            break;
-          case P2_KING:
-            continue;
-          case P2_MAGE:
-            continue;
-          case P2_PAWN:
-            continue;
-          case P2_WARRIOR:
-            continue;
-          case P2_ASSASSIN:
-            continue;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      // pawn can only use abilities on enemy pieces
-      case P2_PAWN:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            break;
-          case P1_MAGE:
-            break;
-          case P1_PAWN:
-            break;
-          case P1_WARRIOR:
-            break;
-          case P1_ASSASSIN:
-            break;
-          case P2_KING:
-            continue;
-          case P2_MAGE:
-            continue;
-          case P2_PAWN:
-            continue;
-          case P2_WARRIOR:
-            continue;
-          case P2_ASSASSIN:
-            continue;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      // warrior can only use abilities on enemy pieces
-      case P2_WARRIOR:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            break;
-          case P1_MAGE:
-            break;
-          case P1_PAWN:
-            break;
-          case P1_WARRIOR:
-            break;
-          case P1_ASSASSIN:
-            break;
-          case P2_KING:
-            continue;
-          case P2_MAGE:
-            continue;
-          case P2_PAWN:
-            continue;
-          case P2_WARRIOR:
-            continue;
-          case P2_ASSASSIN:
-            continue;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      // assassin can only use abilities on enemy pieces
-      case P2_ASSASSIN:
-        switch(destinationSquarePiece->type) {
-          case P1_KING:
-            break;
-          case P1_MAGE:
-            break;
-          case P1_PAWN:
-            break;
-          case P1_WARRIOR:
-            break;
-          case P1_ASSASSIN:
-            break;
-          case P2_KING:
-            continue;
-          case P2_MAGE:
-            continue;
-          case P2_PAWN:
-            continue;
-          case P2_WARRIOR:
-            continue;
-          case P2_ASSASSIN:
-            continue;
-          case NO_PIECE:
-            continue;
-          default:
-            break;
-        }
-        break;
-      case NO_PIECE:
-        break;
-      default:
-        break;
-    }
-    retval.push_back(currentAbility);
+  for(PlayerAbility ability: gameCache->legalAbilities(piece->type, piece->squareIndex)) {
+    // only abilities that hit an enemy piece change the game state
+    if(!abilityEffectTable.effects[piece->type][pieceAt(ability.abilityDstIdx)->type].useful) continue;
+    retval.push_back(ability);
   }
   return retval;
 }
@@ -945,730 +493,164 @@ std::vector<PlayerAbility> Game::usefulLegalAbilitiesByPiece(int srcSquareIdx) {
  * Assumes that the game is not over.
  */
 std::vector<PlayerAbility> Game::allLegalAbilitiesByPiece(int srcSquareIdx) {
+  if(currentPlayer == PLAYER_1) {
+    return allLegalAbilitiesByPieceFor<PLAYER_1>(srcSquareIdx);
+  }
+  return allLegalAbilitiesByPieceFor<PLAYER_2>(srcSquareIdx);
+}
+
+template<Player Us>
+std::vector<PlayerAbility> Game::allLegalAbilitiesByPieceFor(int srcSquareIdx) {
   std::vector<PlayerAbility> retval;
-  Piece* piece = board[srcSquareIdx];
-  if((!pieceBelongsToPlayer(piece->type, currentPlayer)) ||
-      piece->healthPoints <= 0) {
+  Piece* piece = pieceAt(srcSquareIdx);
+  if(!isPieceOf<Us>(piece->type) || piece->healthPoints <= 0) {
     return retval;
   }
-  auto legalAbilitiesOnAnEmptyBoard = gameCache->pieceTypeToSquareIndexToLegalAbilities[piece->type][piece->squareIndex];
+  auto legalAbilitiesOnAnEmptyBoard = gameCache->legalAbilities(piece->type, piece->squareIndex);
 
   for(PlayerAbility pa: legalAbilitiesOnAnEmptyBoard) {
-    Piece* abilityDstPiece = board[pa.abilityDstIdx];
-    if(pieceBelongsToPlayer(abilityDstPiece->type, currentPlayer)) continue;
+    // abilities on empty squares are legal, on own pieces they aren't
+    if(isPieceOf<Us>(pieceAt(pa.abilityDstIdx)->type)) continue;
     retval.push_back(pa);
   }
   return retval;
 }
 
+/*
+ * Squares of Us's living pieces, one mask per ability table.
+ */
+template<Player Us>
+void Game::abilitySources(uint64_t* sources) const {
+  const Piece& mage = pieces[Us][MAGE_PIECE_INDEX];
+  sources[MAGE_ABILITIES] = mage.healthPoints > 0 ? squareMask(mage.squareIndex) : 0;
+  sources[ONE_SQUARE_ABILITIES] = occupancy[Us] & ~sources[MAGE_ABILITIES];
+}
+
+/*
+ * Pushes the move combined with every useful ability, i.e. every ability that hits an enemy
+ * piece. Generation starts from the enemy pieces: the reverse table gives the squares that
+ * reach an enemy with each ability table, and sources the current player's pieces on them.
+ */
+template<Player Us, typename ActionContainer>
+void Game::pushUsefulAbilities(int moveSrcIdx, int moveDstIdx, const uint64_t* sources, ActionContainer& retval) const {
+  for(uint64_t targets = occupancy[~Us]; targets != 0; ) {
+    int abilityDstIdx = popLsb(targets);
+    for(int table = 0; table < NUM_ABILITY_SOURCES; table++) {
+      for(uint64_t attackers = reverseAbilityTable.masks[table][abilityDstIdx] & sources[table]; attackers != 0; ) {
+        retval.push_back(PlayerAction(moveSrcIdx, moveDstIdx, popLsb(attackers), abilityDstIdx));
+      }
+    }
+  }
+}
+
 /*
  * Useful actions are those whose abilities change the game state.
  * For example, warrior attacking an empty square is legal but doesn't change the game state.
  */
-std::vector<PlayerAction> Game::usefulLegalActions() {
-  std::vector<PlayerAction> retval;
+template<typename ActionContainer>
+void Game::generateUsefulLegalActions(ActionContainer& retval) {
+  if(currentPlayer == PLAYER_1) {
+    generateUsefulLegalActionsFor<PLAYER_1>(retval);
+  } else {
+    generateUsefulLegalActionsFor<PLAYER_2>(retval);
+  }
+}
+
+template<Player Us, typename ActionContainer>
+void Game::generateUsefulLegalActionsFor(ActionContainer& retval) {
   // If King is dead, game is over and there are no legal actions
-  if(playerToPieces[currentPlayer][KING_PIECE_INDEX]->healthPoints <= 0) {
-    return retval;
+  if(pieces[Us][KING_PIECE_INDEX].healthPoints <= 0) {
+    return;
   }
+  uint64_t sources[NUM_ABILITY_SOURCES];
+  abilitySources<Us>(sources);
   for(int i = 0; i < NUM_STARTING_PIECES; i++) {
-    Piece* currentPiece = playerToPieces[currentPlayer][i];
+    Piece* currentPiece = &pieces[Us][i];
     if(currentPiece->healthPoints <= 0) continue; // dead pieces don't move
+    int movingTable = pieceTypeToAbilityTable[currentPiece->type];
 
-    auto legalMoves = gameCache->pieceTypeToSquareIndexToLegalMoves[currentPiece->type][currentPiece->squareIndex];
+    auto legalMoves = gameCache->legalMoves(currentPiece->type, currentPiece->squareIndex);
     for(int j = 0; j < legalMoves.size(); j++) {
       PlayerMove currentMove = legalMoves[j];
-      // Is p1 pawn trying to jump over another piece?
-      if(currentPiece->type == P1_PAWN &&
-          currentPiece->squareIndex - currentMove.moveDstIdx == -2 * NUM_COLUMNS 
-          ) {
-        // checks whether square in front of the p1 pawn is empty
-        if(board[currentPiece->squareIndex + NUM_COLUMNS]->type != NO_PIECE) continue;
-      }
-      // Is p2 pawn trying to jump over another piece?
-      if(currentPiece->type == P2_PAWN &&
-          currentPiece->squareIndex - currentMove.moveDstIdx == 2 * NUM_COLUMNS 
-          ) {
-        // checks whether square in front of the p2 pawn is empty
-        if(board[currentPiece->squareIndex - NUM_COLUMNS]->type != NO_PIECE) continue;
-      }
-
-      if(board[currentMove.moveDstIdx]->type != NO_PIECE) continue;
-      makeMove(currentMove.moveSrcIdx, currentMove.moveDstIdx);
-      for(int k = 0; k < NUM_STARTING_PIECES; k++) {
-        Piece* cp2 = playerToPieces[currentPlayer][k];
-        if(cp2->healthPoints <= 0) continue; // no abilities for dead pieces
-        auto legalAbilities = gameCache->pieceTypeToSquareIndexToLegalAbilities[cp2->type][cp2->squareIndex];
-        for(int l = 0; l < legalAbilities.size(); l++) {
-          PlayerAbility currentAbility = legalAbilities[l];
-          Piece* destinationSquarePiece = board[currentAbility.abilityDstIdx];
-          // exclude useless abilities, e.g. warrior attacking empty square
-          switch(cp2->type) {
-            // king can only use abilities on enemy pieces
-            case P1_KING:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  continue;
-                case P1_MAGE:
-                  continue;
-                case P1_PAWN:
-                  continue;
-                case P1_WARRIOR:
-                  continue;
-                case P1_ASSASSIN:
-                  continue;
-                case P2_KING:
-                  break;
-                case P2_MAGE:
-                  break;
-                case P2_PAWN:
-                  break;
-                case P2_WARRIOR:
-                  break;
-                case P2_ASSASSIN:
-                  break;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-            // mage can only use abilities on enemy pieces
-            case P1_MAGE:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  continue;
-                case P1_MAGE:
-                  continue;
-                case P1_PAWN:
-                  continue;
-                case P1_WARRIOR:
-                  continue;
-                case P1_ASSASSIN:
-                  continue;
-                case P2_KING:
-                  break;
-                case P2_MAGE:
-                  break;
-                case P2_PAWN:
-                  break;
-                case P2_WARRIOR:
-                  break;
-                case P2_ASSASSIN:
-                  break;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            // pawn can only use abilities on enemy pieces
-            case P1_PAWN:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  continue;
-                case P1_MAGE:
-                  continue;
-                case P1_PAWN:
-                  continue;
-                case P1_WARRIOR:
-                  continue;
-                case P1_ASSASSIN:
-                  continue;
-                case P2_KING:
-                  break;
-                case P2_MAGE:
-                  break;
-                case P2_PAWN:
-                  break;
-                case P2_WARRIOR:
-                  break;
-                case P2_ASSASSIN:
-                  break;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            // warrior can only use abilities on enemy pieces
-            case P1_WARRIOR:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  continue;
-                case P1_MAGE:
-                  continue;
-                case P1_PAWN:
-                  continue;
-                case P1_WARRIOR:
-                  continue;
-                case P1_ASSASSIN:
-                  continue;
-                case P2_KING:
-                  break;
-                case P2_MAGE:
-                  break;
-                case P2_PAWN:
-                  break;
-                case P2_WARRIOR:
-                  break;
-                case P2_ASSASSIN:
-                  break;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            // assassin can only use abilities on enemy pieces
-            case P1_ASSASSIN:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  continue;
-                case P1_MAGE:
-                  continue;
-                case P1_PAWN:
-                  continue;
-                case P1_WARRIOR:
-                  continue;
-                case P1_ASSASSIN:
-                  continue;
-                case P2_KING:
-                  break;
-                case P2_MAGE:
-                  break;
-                case P2_PAWN:
-                  break;
-                case P2_WARRIOR:
-                  break;
-                case P2_ASSASSIN:
-                  break;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-
-            // king can only use abilities on enemy pieces
-            case P2_KING:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  break;
-                case P1_MAGE:
-                  break;
-                case P1_PAWN:
-                  break;
-                case P1_WARRIOR:
-                  break;
-                case P1_ASSASSIN:
-                  break;
-                case P2_KING:
-                  continue;
-                case P2_MAGE:
-                  continue;
-                case P2_PAWN:
-                  continue;
-                case P2_WARRIOR:
-                  continue;
-                case P2_ASSASSIN:
-                  continue;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-            // mage can only use abilities on enemy pieces
-            case P2_MAGE:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  break;
-                case P1_MAGE:
-                  break;
-                case P1_PAWN:
-                  break;
-                case P1_WARRIOR:
-                  break;
-                case P1_ASSASSIN:
-                  break;
-                case P2_KING:
-                  continue;
-                case P2_MAGE:
-                  continue;
-                case P2_PAWN:
-                  continue;
-                case P2_WARRIOR:
-                  continue;
-                case P2_ASSASSIN:
-                  continue;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            // pawn can only use abilities on enemy pieces
-            case P2_PAWN:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  break;
-                case P1_MAGE:
-                  break;
-                case P1_PAWN:
-                  break;
-                case P1_WARRIOR:
-                  break;
-                case P1_ASSASSIN:
-                  break;
-                case P2_KING:
-                  continue;
-                case P2_MAGE:
-                  continue;
-                case P2_PAWN:
-                  continue;
-                case P2_WARRIOR:
-                  continue;
-                case P2_ASSASSIN:
-                  continue;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            // warrior can only use abilities on enemy pieces
-            case P2_WARRIOR:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  break;
-                case P1_MAGE:
-                  break;
-                case P1_PAWN:
-                  break;
-                case P1_WARRIOR:
-                  break;
-                case P1_ASSASSIN:
-                  break;
-                case P2_KING:
-                  continue;
-                case P2_MAGE:
-                  continue;
-                case P2_PAWN:
-                  continue;
-                case P2_WARRIOR:
-                  continue;
-                case P2_ASSASSIN:
-                  continue;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            // assassin can only use abilities on enemy pieces
-            case P2_ASSASSIN:
-              switch(destinationSquarePiece->type) {
-                case P1_KING:
-                  break;
-                case P1_MAGE:
-                  break;
-                case P1_PAWN:
-                  break;
-                case P1_WARRIOR:
-                  break;
-                case P1_ASSASSIN:
-                  break;
-                case P2_KING:
-                  continue;
-                case P2_MAGE:
-                  continue;
-                case P2_PAWN:
-                  continue;
-                case P2_WARRIOR:
-                  continue;
-                case P2_ASSASSIN:
-                  continue;
-                case NO_PIECE:
-                  continue;
-                default:
-                  break;
-              }
-              break;
-            case NO_PIECE:
-              break;
-            default:
-              break;
-          }
-          PlayerAction p = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, currentAbility.abilitySrcIdx, currentAbility.abilityDstIdx);
-          retval.push_back(p);
-        }
-      }
+      if(pawnJumpBlocked<Us>(*currentPiece, currentMove.moveDstIdx)) continue;
+      if(!isSquareEmpty(currentMove.moveDstIdx)) continue;
+      // sources after the move, only the moving piece's bit changes
+      uint64_t movedSources[NUM_ABILITY_SOURCES];
+      std::copy(sources, sources + NUM_ABILITY_SOURCES, movedSources);
+      movedSources[movingTable] ^= squareMask(currentMove.moveSrcIdx) | squareMask(currentMove.moveDstIdx);
+      pushUsefulAbilities<Us>(currentMove.moveSrcIdx, currentMove.moveDstIdx, movedSources, retval);
       // player can skip the ability
       PlayerAction p = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, ABILITY_SKIP, ABILITY_SKIP);
       retval.push_back(p);
-
-      undoMove(currentMove.moveSrcIdx, currentMove.moveDstIdx);
     }
   }
   // player can skip the move
-  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
-    Piece* cp2 = playerToPieces[currentPlayer][k];
-    if(cp2->healthPoints <= 0) continue; // no abilities for dead pieces
-    auto legalAbilities = gameCache->pieceTypeToSquareIndexToLegalAbilities[cp2->type][cp2->squareIndex];
-    for(int l = 0; l < legalAbilities.size(); l++) {
-      Piece* destinationSquarePiece = board[legalAbilities[l].abilityDstIdx];
-      // exclude useless abilities
-      switch(cp2->type) {
-        // king can only use abilities on enemy pieces
-        case P1_KING:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              continue;
-            case P1_MAGE:
-              continue;
-            case P1_PAWN:
-              continue;
-            case P1_WARRIOR:
-              continue;
-            case P1_ASSASSIN:
-              continue;
-            case P2_KING:
-              break;
-            case P2_MAGE:
-              break;
-            case P2_PAWN:
-              break;
-            case P2_WARRIOR:
-              break;
-            case P2_ASSASSIN:
-              break;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-        // mage can only use abilities on enemy pieces
-        case P1_MAGE:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              continue;
-            case P1_MAGE:
-              continue;
-            case P1_PAWN:
-              continue;
-            case P1_WARRIOR:
-              continue;
-            case P1_ASSASSIN:
-              continue;
-            case P2_KING:
-              break;
-            case P2_MAGE:
-              break;
-            case P2_PAWN:
-              break;
-            case P2_WARRIOR:
-              break;
-            case P2_ASSASSIN:
-              break;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        // pawn can only use abilities on enemy pieces
-        case P1_PAWN:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              continue;
-            case P1_MAGE:
-              continue;
-            case P1_PAWN:
-              continue;
-            case P1_WARRIOR:
-              continue;
-            case P1_ASSASSIN:
-              continue;
-            case P2_KING:
-              break;
-            case P2_MAGE:
-              break;
-            case P2_PAWN:
-              break;
-            case P2_WARRIOR:
-              break;
-            case P2_ASSASSIN:
-              break;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        // warrior can only use abilities on enemy pieces
-        case P1_WARRIOR:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              continue;
-            case P1_MAGE:
-              continue;
-            case P1_PAWN:
-              continue;
-            case P1_WARRIOR:
-              continue;
-            case P1_ASSASSIN:
-              continue;
-            case P2_KING:
-              break;
-            case P2_MAGE:
-              break;
-            case P2_PAWN:
-              break;
-            case P2_WARRIOR:
-              break;
-            case P2_ASSASSIN:
-              break;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        // assassin can only use abilities on enemy pieces
-        case P1_ASSASSIN:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              continue;
-            case P1_MAGE:
-              continue;
-            case P1_PAWN:
-              continue;
-            case P1_WARRIOR:
-              continue;
-            case P1_ASSASSIN:
-              continue;
-            case P2_KING:
-              break;
-            case P2_MAGE:
-              break;
-            case P2_PAWN:
-              break;
-            case P2_WARRIOR:
-              break;
-            case P2_ASSASSIN:
-              break;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-
-        // king can only use abilities on enemy pieces
-        case P2_KING:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              break;
-            case P1_MAGE:
-              break;
-            case P1_PAWN:
-              break;
-            case P1_WARRIOR:
-              break;
-            case P1_ASSASSIN:
-              break;
-            case P2_KING:
-              continue;
-            case P2_MAGE:
-              continue;
-            case P2_PAWN:
-              continue;
-            case P2_WARRIOR:
-              continue;
-            case P2_ASSASSIN:
-              continue;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-        // mage can only use abilities on enemy pieces
-        case P2_MAGE:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              break;
-            case P1_MAGE:
-              break;
-            case P1_PAWN:
-              break;
-            case P1_WARRIOR:
-              break;
-            case P1_ASSASSIN:
-              break;
-            case P2_KING:
-              continue;
-            case P2_MAGE:
-              continue;
-            case P2_PAWN:
-              continue;
-            case P2_WARRIOR:
-              continue;
-            case P2_ASSASSIN:
-              continue;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        // pawn can only use abilities on enemy pieces
-        case P2_PAWN:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              break;
-            case P1_MAGE:
-              break;
-            case P1_PAWN:
-              break;
-            case P1_WARRIOR:
-              break;
-            case P1_ASSASSIN:
-              break;
-            case P2_KING:
-              continue;
-            case P2_MAGE:
-              continue;
-            case P2_PAWN:
-              continue;
-            case P2_WARRIOR:
-              continue;
-            case P2_ASSASSIN:
-              continue;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        // warrior can only use abilities on enemy pieces
-        case P2_WARRIOR:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              break;
-            case P1_MAGE:
-              break;
-            case P1_PAWN:
-              break;
-            case P1_WARRIOR:
-              break;
-            case P1_ASSASSIN:
-              break;
-            case P2_KING:
-              continue;
-            case P2_MAGE:
-              continue;
-            case P2_PAWN:
-              continue;
-            case P2_WARRIOR:
-              continue;
-            case P2_ASSASSIN:
-              continue;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        // assassin can only use abilities on enemy pieces
-        case P2_ASSASSIN:
-          switch(destinationSquarePiece->type) {
-            case P1_KING:
-              break;
-            case P1_MAGE:
-              break;
-            case P1_PAWN:
-              break;
-            case P1_WARRIOR:
-              break;
-            case P1_ASSASSIN:
-              break;
-            case P2_KING:
-              continue;
-            case P2_MAGE:
-              continue;
-            case P2_PAWN:
-              continue;
-            case P2_WARRIOR:
-              continue;
-            case P2_ASSASSIN:
-              continue;
-            case NO_PIECE:
-              continue;
-            default:
-              break;
-          }
-          break;
-        case NO_PIECE:
-          break;
-        default:
-          break;
-      }
-
-      PlayerAction p = PlayerAction(MOVE_SKIP, MOVE_SKIP, legalAbilities[l].abilitySrcIdx, legalAbilities[l].abilityDstIdx);
-      retval.push_back(p);
-    }
-  }
+  pushUsefulAbilities<Us>(MOVE_SKIP, MOVE_SKIP, sources, retval);
   // player can skip both move and ability
   PlayerAction p = PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
   retval.push_back(p);
+}
+
+std::vector<PlayerAction> Game::usefulLegalActions() {
+  std::vector<PlayerAction> retval;
+  generateUsefulLegalActions(retval);
   return retval;
 }
 
+/*
+ * Same actions in the same order as usefulLegalActions(), written into a caller-owned list.
+ */
+void Game::usefulLegalActions(ActionList& actions) {
+  actions.clear();
+  generateUsefulLegalActions(actions);
+}
+
 /*
  * Includes actions with useless abilities (i.e. those that don't alter the game state)
  */
-std::vector<PlayerAction> Game::allLegalActions() {
-  std::vector<PlayerAction> retval;
+template<typename ActionContainer>
+void Game::generateAllLegalActions(ActionContainer& retval) {
+  if(currentPlayer == PLAYER_1) {
+    generateAllLegalActionsFor<PLAYER_1>(retval);
+  } else {
+    generateAllLegalActionsFor<PLAYER_2>(retval);
+  }
+}
+
+/*
+ * Pushes the move combined with every legal ability of Us's living pieces.
+ */
+template<Player Us, typename ActionContainer>
+void Game::pushAllAbilities(int moveSrcIdx, int moveDstIdx, ActionContainer& retval) const {
+  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
+    const Piece* cp2 = &pieces[Us][k];
+    if(cp2->healthPoints <= 0) continue; // no abilities for dead pieces
+    auto legalAbilities = gameCache->legalAbilities(cp2->type, cp2->squareIndex);
+    for(int l = 0; l < legalAbilities.size(); l++) {
+      PlayerAbility currentAbility = legalAbilities[l];
+      if(isPieceOf<Us>(pieceAt(currentAbility.abilityDstIdx)->type)) continue;
+      retval.push_back(PlayerAction(moveSrcIdx, moveDstIdx, currentAbility.abilitySrcIdx, currentAbility.abilityDstIdx));
+    }
+  }
+}
+
+template<Player Us, typename ActionContainer>
+void Game::generateAllLegalActionsFor(ActionContainer& retval) {
   // If King is dead, game is over and there are no legal actions
-  if(playerToPieces[currentPlayer][KING_PIECE_INDEX]->healthPoints <= 0) {
-    return retval;
+  if(pieces[Us][KING_PIECE_INDEX].healthPoints <= 0) {
+    return;
   }
   for(int i = 0; i < NUM_STARTING_PIECES; i++) {
-    Piece* currentPiece = playerToPieces[currentPlayer][i];
+    Piece* currentPiece = &pieces[Us][i];
     if(currentPiece->healthPoints <= 0) continue; // dead pieces don't move
 
-    auto legalMoves = gameCache->pieceTypeToSquareIndexToLegalMoves[currentPiece->type][currentPiece->squareIndex];
+    auto legalMoves = gameCache->legalMoves(currentPiece->type, currentPiece->squareIndex);
     for(int j = 0; j < legalMoves.size(); j++) {
       PlayerMove currentMove = legalMoves[j];
-      // Is p1 pawn trying to jump over another piece?
-      if(currentPiece->type == P1_PAWN &&
-          currentPiece->squareIndex - currentMove.moveDstIdx == -2 * NUM_COLUMNS 
-          ) {
-        // checks whether square in front of the p1 pawn is empty
-        if(board[currentPiece->squareIndex + NUM_COLUMNS]->type != NO_PIECE) continue;
-      }
-      // Is p2 pawn trying to jump over another piece?
-      if(currentPiece->type == P2_PAWN &&
-          currentPiece->squareIndex - currentMove.moveDstIdx == 2 * NUM_COLUMNS 
-          ) {
-        // checks whether square in front of the p2 pawn is empty
-        if(board[currentPiece->squareIndex - NUM_COLUMNS]->type != NO_PIECE) continue;
-      }
-
-      if(board[currentMove.moveDstIdx]->type != NO_PIECE) continue;
+      if(pawnJumpBlocked<Us>(*currentPiece, currentMove.moveDstIdx)) continue;
+      if(!isSquareEmpty(currentMove.moveDstIdx)) continue;
       makeMove(currentMove.moveSrcIdx, currentMove.moveDstIdx);
-      for(int k = 0; k < NUM_STARTING_PIECES; k++) {
-        Piece* cp2 = playerToPieces[currentPlayer][k];
-        if(cp2->healthPoints <= 0) continue; // no abilities for dead pieces
-        auto legalAbilities = gameCache->pieceTypeToSquareIndexToLegalAbilities[cp2->type][cp2->squareIndex];
-        for(int l = 0; l < legalAbilities.size(); l++) {
-          PlayerAbility currentAbility = legalAbilities[l];
-          Piece* destinationSquarePiece = board[currentAbility.abilityDstIdx];
-          if(pieceBelongsToPlayer(destinationSquarePiece->type, this->currentPlayer)) continue;
-
-          PlayerAction p = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, currentAbility.abilitySrcIdx, currentAbility.abilityDstIdx);
-          retval.push_back(p);
-        }
-      }
+      pushAllAbilities<Us>(currentMove.moveSrcIdx, currentMove.moveDstIdx, retval);
       // player can skip the ability
       PlayerAction p = PlayerAction(currentMove.moveSrcIdx, currentMove.moveDstIdx, ABILITY_SKIP, ABILITY_SKIP);
       retval.push_back(p);
@@ -1677,23 +659,26 @@ std::vector<PlayerAction> Game::allLegalActions() {
     }
   }
   // player can skip the move
-  for(int k = 0; k < NUM_STARTING_PIECES; k++) {
-    Piece* cp2 = playerToPieces[currentPlayer][k];
-    if(cp2->healthPoints <= 0) continue; // no abilities for dead pieces
-    auto legalAbilities = gameCache->pieceTypeToSquareIndexToLegalAbilities[cp2->type][cp2->squareIndex];
-    for(int l = 0; l < legalAbilities.size(); l++) {
-      Piece* destinationSquarePiece = board[legalAbilities[l].abilityDstIdx];
-      if(pieceBelongsToPlayer(destinationSquarePiece->type, this->currentPlayer)) continue;
-      PlayerAction p = PlayerAction(MOVE_SKIP, MOVE_SKIP, legalAbilities[l].abilitySrcIdx, legalAbilities[l].abilityDstIdx);
-      retval.push_back(p);
-    }
-  }
+  pushAllAbilities<Us>(MOVE_SKIP, MOVE_SKIP, retval);
   // player can skip both move and ability
   PlayerAction p = PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
   retval.push_back(p);
+}
+
+std::vector<PlayerAction> Game::allLegalActions() {
+  std::vector<PlayerAction> retval;
+  generateAllLegalActions(retval);
   return retval;
 }
 
+/*
+ * Same actions in the same order as allLegalActions(), written into a caller-owned list.
+ */
+void Game::allLegalActions(ActionList& actions) {
+  actions.clear();
+  generateAllLegalActions(actions);
+}
+
 /*
  * Checks whether values are in the right range.
  */
@@ -1714,6 +699,14 @@ bool isActionValid(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilit
 }
 
 bool Game::isActionLegal(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
+  if(currentPlayer == PLAYER_1) {
+    return isActionLegalFor<PLAYER_1>(moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx);
+  }
+  return isActionLegalFor<PLAYER_2>(moveSrcIdx, moveDstIdx, abilitySrcIdx, abilityDstIdx);
+}
+
+template<Player Us>
+bool Game::isActionLegalFor(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int abilityDstIdx) {
   // It's important for this method to not have many exit points because it's altering the game
   // state. If a return statement is between makeMove and undoMove, game state will remain changed
   // which shouldn't happen in a method that checks action legality.
@@ -1737,33 +730,18 @@ bool Game::isActionLegal(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int
     movePieceBelongsToCurrentPlayerOrMoveSkip = true;
     movePieceIsAliveOrMoveSkip = true;
   } else {
-    movePiece = board[moveSrcIdx];
-    if(pieceBelongsToPlayer(movePiece->type, currentPlayer)) {
+    movePiece = pieceAt(moveSrcIdx);
+    if(isPieceOf<Us>(movePiece->type)) {
       movePieceBelongsToCurrentPlayerOrMoveSkip = true;
     }
     if(movePiece->healthPoints > 0) {
       movePieceIsAliveOrMoveSkip = true;
     }
-    auto legalMovesOnEmptyBoard = gameCache->pieceTypeToSquareIndexToLegalMoves[movePiece->type][movePiece->squareIndex];
+    auto legalMovesOnEmptyBoard = gameCache->legalMoves(movePiece->type, movePiece->squareIndex);
     for(int i = 0; i < legalMovesOnEmptyBoard.size(); i++) {
       PlayerMove currentMove = legalMovesOnEmptyBoard[i];
-      // Is p1 pawn trying to jump over another piece?
-      if(movePiece->type == P1_PAWN &&
-          movePiece->squareIndex - currentMove.moveDstIdx == -2 * NUM_COLUMNS 
-          ) {
-        // checks whether square in front of the p1 pawn is empty
-        if(board[movePiece->squareIndex + NUM_COLUMNS]->type != NO_PIECE) continue;
-      }
-
-      // Is p2 pawn trying to jump over another piece?
-      if(movePiece->type == P2_PAWN &&
-          movePiece->squareIndex - currentMove.moveDstIdx == 2 * NUM_COLUMNS 
-          ) {
-        // checks whether square in front of the p2 pawn is empty
-        if(board[movePiece->squareIndex - NUM_COLUMNS]->type != NO_PIECE) continue;
-      }
-
-      if(board[currentMove.moveDstIdx]->type == NO_PIECE && 
+      if(pawnJumpBlocked<Us>(*movePiece, currentMove.moveDstIdx)) continue;
+      if(isSquareEmpty(currentMove.moveDstIdx) && 
           currentMove.moveDstIdx == moveDstIdx) {
         moveLegal = true;
         makeMove(moveSrcIdx, moveDstIdx);
@@ -1776,18 +754,18 @@ bool Game::isActionLegal(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int
     abilityPieceBelongsToCurrentPlayerOrAbilitySkip = true;
     abilityPieceIsAliveOrAbilitySkip = true;
   } else {
-    abilityPiece = board[abilitySrcIdx];
-    abilityDstPiece = board[abilityDstIdx];
-    if(pieceBelongsToPlayer(abilityPiece->type, currentPlayer)) {
+    abilityPiece = pieceAt(abilitySrcIdx);
+    abilityDstPiece = pieceAt(abilityDstIdx);
+    if(isPieceOf<Us>(abilityPiece->type)) {
       abilityPieceBelongsToCurrentPlayerOrAbilitySkip = true;
     }
     if(abilityPiece->healthPoints > 0) {
       abilityPieceIsAliveOrAbilitySkip = true;
     }
-    if(pieceBelongsToPlayer(abilityDstPiece->type, this->currentPlayer)) {
+    if(isPieceOf<Us>(abilityDstPiece->type)) {
       abilityDstPieceBelongsToCurrentPlayer = true;
     }
-    auto legalAbilitiesOnEmptyBoard = gameCache->pieceTypeToSquareIndexToLegalAbilities[abilityPiece->type][abilityPiece->squareIndex];
+    auto legalAbilitiesOnEmptyBoard = gameCache->legalAbilities(abilityPiece->type, abilityPiece->squareIndex);
     for(int i = 0; i < legalAbilitiesOnEmptyBoard.size(); i++) {
       PlayerAbility currentAbility = legalAbilitiesOnEmptyBoard[i];
       if(currentAbility.abilityDstIdx == abilityDstIdx) {
@@ -1801,7 +779,7 @@ bool Game::isActionLegal(int moveSrcIdx, int moveDstIdx, int abilitySrcIdx, int
     undoMove(moveSrcIdx, moveDstIdx);
   }
 
-  currentPlayersKingIsAlive = playerToPieces[currentPlayer][KING_PIECE_INDEX]->healthPoints > 0;
+  currentPlayersKingIsAlive = pieces[Us][KING_PIECE_INDEX].healthPoints > 0;
   
   if(moveLegal && abilityLegal && movePieceBelongsToCurrentPlayerOrMoveSkip &&
       abilityPieceBelongsToCurrentPlayerOrAbilitySkip && movePieceIsAliveOrMoveSkip &&
@@ -1818,16 +796,18 @@ Player Game::getCurrentPlayer() {
 }
 
 Piece Game::getPieceByCoordinates(int x, int y) {
-  return *board[coordinatesToBoardIndex(x, y)]; 
+  return getPieceBySquareIndex(coordinatesToBoardIndex(x, y));
 }
 
 Piece Game::getPieceBySquareIndex(int squareIndex) {
-  return *board[squareIndex]; 
+  Piece retval = *pieceAt(squareIndex);
+  retval.squareIndex = squareIndex;
+  return retval;
 }
 
 bool Game::gameOver() {
-  Piece* p1King = playerToPieces[PLAYER_1][KING_PIECE_INDEX];
-  Piece* p2King = playerToPieces[PLAYER_2][KING_PIECE_INDEX];
+  const Piece* p1King = &pieces[PLAYER_1][KING_PIECE_INDEX];
+  const Piece* p2King = &pieces[PLAYER_2][KING_PIECE_INDEX];
   if(p1King->healthPoints <= 0 || p2King->healthPoints <= 0) {
     return true;
   } else {
@@ -1836,8 +816,8 @@ bool Game::gameOver() {
 }
 
 std::optional<Player> Game::winner() {
-  Piece* p1King = playerToPieces[PLAYER_1][KING_PIECE_INDEX];
-  Piece* p2King = playerToPieces[PLAYER_2][KING_PIECE_INDEX];
+  const Piece* p1King = &pieces[PLAYER_1][KING_PIECE_INDEX];
+  const Piece* p2King = &pieces[PLAYER_2][KING_PIECE_INDEX];
   if(p1King->healthPoints <= 0) {
     return PLAYER_2;
   } else if(p2King->healthPoints <= 0) {
@@ -1846,180 +826,228 @@ std::optional<Player> Game::winner() {
   return std::nullopt;
 }
 
+// Piece names in the text format and the slot of the first piece of that type
+static const std::string_view pieceNames[] = {"king", "mage", "warrior", "assassin", "pawn"};
+static const int pieceNameSlots[] = {KING_PIECE_INDEX, MAGE_PIECE_INDEX, WARRIOR_PIECE_INDEX, ASSASSIN_PIECE_INDEX, PAWN_1_PIECE_INDEX};
+static const int PAWN_NAME = 4;
+
+const char* nichess::parseErrorToString(ParseError error) {
+  switch(error) {
+    case PARSE_OK:
+      return "OK";
+    case PARSE_BAD_PLAYER:
+      return "Player to move must be 0 or 1, followed by '|'";
+    case PARSE_BAD_TOKEN:
+      return "Square must be 'empty' or <player>-<piece>-<health points>";
+    case PARSE_BAD_HEALTH_POINTS:
+      return "Health points must be a positive number";
+    case PARSE_TOO_MANY_PIECES:
+      return "Too many living pieces of one type";
+    case PARSE_BAD_SQUARE_COUNT:
+      return "Board must have 64 squares";
+  }
+  return "Unknown error";
+}
+
 std::string Game::boardToString() {
-  std::stringstream retval;
-  retval << currentPlayer << "|";
-  Piece* currentPiece;
+  std::string retval;
+  retval.reserve(MAX_BOARD_STRING_LENGTH);
+  appendBoard(retval);
+  return retval;
+}
+
+/*
+ * Appends the text encoding to out. Doesn't allocate if out has MAX_BOARD_STRING_LENGTH
+ * spare capacity.
+ */
+void Game::appendBoard(std::string& out) const {
+  out.push_back((char) ('0' + currentPlayer));
+  out.push_back('|');
+  char digits[16];
   for(int i = 0; i < NUM_SQUARES; i++) {
-    currentPiece = board[i];
-    if(currentPiece->type == NO_PIECE) {
-      retval << "empty,";
-    } else {
-      switch(currentPiece->type) {
-        case P1_KING:
-          retval << "0-king-";
-          break;
-        case P1_MAGE:
-          retval << "0-mage-";
-          break;
-        case P1_PAWN:
-          retval << "0-pawn-";
-          break;
-        case P1_WARRIOR:
-          retval << "0-warrior-";
-          break;
-        case P1_ASSASSIN:
-          retval << "0-assassin-";
-          break;
-        case P2_KING:
-          retval << "1-king-";
-          break;
-        case P2_MAGE:
-          retval << "1-mage-";
-          break;
-        case P2_PAWN:
-          retval << "1-pawn-";
-          break;
-        case P2_WARRIOR:
-          retval << "1-warrior-";
-          break;
-        case P2_ASSASSIN:
-          retval << "1-assassin-";
-          break;
-      }        
-      retval << currentPiece->healthPoints << ",";
+    const Piece* currentPiece = pieceAt(i);
+    out.append(pieceTypeTokens[currentPiece->type]);
+    if(currentPiece->type != NO_PIECE) {
+      char* end = std::to_chars(digits, digits + sizeof(digits), currentPiece->healthPoints).ptr;
+      out.append(digits, end - digits);
     }
+    out.push_back(',');
   }
-  return retval.str();
 }
 
 void Game::boardFromString(std::string encodedBoard) {
-  currentPlayer = (Player)(std::stoi(encodedBoard.substr(0, encodedBoard.find("|"))));
-  moveNumber = 0;
-  // pieces need to exist in the piece array even if they're dead
-  // first all pieces are initialized as dead, then they're replaced if found in the encodedBoard
-  std::vector<Piece*> p1Pieces(NUM_STARTING_PIECES);
-  p1Pieces[KING_PIECE_INDEX] = new Piece(PieceType::P1_KING, 0, 0);
-  p1Pieces[PAWN_1_PIECE_INDEX] = new Piece(PieceType::P1_PAWN, 0, 0);
-  p1Pieces[PAWN_2_PIECE_INDEX] = new Piece(PieceType::P1_PAWN, 0, 0);
-  p1Pieces[PAWN_3_PIECE_INDEX] = new Piece(PieceType::P1_PAWN, 0, 0);
-  p1Pieces[ASSASSIN_PIECE_INDEX] = new Piece(PieceType::P1_ASSASSIN, 0, 0);
-  p1Pieces[MAGE_PIECE_INDEX] = new Piece(PieceType::P1_MAGE, 0, 0);
-  p1Pieces[WARRIOR_PIECE_INDEX] = new Piece(PieceType::P1_WARRIOR, 0, 0);
-
-  p1King = p1Pieces[KING_PIECE_INDEX];
-
-  std::vector<Piece*> p2Pieces(NUM_STARTING_PIECES);
-  p2Pieces[KING_PIECE_INDEX] = new Piece(PieceType::P2_KING, 0, 0);
-  p2Pieces[PAWN_1_PIECE_INDEX] = new Piece(PieceType::P2_PAWN, 0, 0);
-  p2Pieces[PAWN_2_PIECE_INDEX] = new Piece(PieceType::P2_PAWN, 0, 0);
-  p2Pieces[PAWN_3_PIECE_INDEX] = new Piece(PieceType::P2_PAWN, 0, 0);
-  p2Pieces[ASSASSIN_PIECE_INDEX] = new Piece(PieceType::P2_ASSASSIN, 0, 0);
-  p2Pieces[MAGE_PIECE_INDEX] = new Piece(PieceType::P2_MAGE, 0, 0);
-  p2Pieces[WARRIOR_PIECE_INDEX] = new Piece(PieceType::P2_WARRIOR, 0, 0);
-
-  p2King = p2Pieces[KING_PIECE_INDEX];
-
-  std::string b1 = encodedBoard.substr(2);
-  std::string delimiter1 = ",";
-  std::string delimiter2 = "-";
-  std::string token1;
-  std::string s, tmp;
-  size_t pos = 0;
-  int boardIdx = 0;
-  while((pos = b1.find(delimiter1)) != std::string::npos) {
-    token1 = b1.substr(0, pos);
-    if(token1 == "empty") {
-      board[boardIdx] = new Piece(PieceType::NO_PIECE, 0, boardIdx);
-    } else {
-      std::stringstream ss(token1);
-      std::vector<std::string> words;
-      while(std::getline(ss, tmp, '-')) {
-        words.push_back(tmp);
-      }
-      int healthPoints = std::stoi(words[2]);
-      s = words[0] + words[1];
-      if(s == "0king") {
-        board[boardIdx] = new Piece(PieceType::P1_KING, healthPoints, boardIdx);
-        p1Pieces[KING_PIECE_INDEX] = board[boardIdx];
-        p1King = board[boardIdx];
-      } else if(s == "0pawn") {
-        board[boardIdx] = new Piece(PieceType::P1_PAWN, healthPoints, boardIdx);
-        if(p1Pieces[PAWN_1_PIECE_INDEX]->healthPoints <= 0) {
-          p1Pieces[PAWN_1_PIECE_INDEX] = board[boardIdx];
-        } else if(p1Pieces[PAWN_2_PIECE_INDEX]->healthPoints <= 0) {
-          p1Pieces[PAWN_2_PIECE_INDEX] = board[boardIdx];
-        } else if(p1Pieces[PAWN_3_PIECE_INDEX]->healthPoints <= 0) {
-          p1Pieces[PAWN_3_PIECE_INDEX] = board[boardIdx];
-        } else {
-          throw "Already found 3 living PLAYER_1 Pawns";
-        }
-      } else if(s == "0mage") {
-        board[boardIdx] = new Piece(PieceType::P1_MAGE, healthPoints, boardIdx);
-        p1Pieces[MAGE_PIECE_INDEX] = board[boardIdx];
-      } else if(s == "0assassin") {
-        board[boardIdx] = new Piece(PieceType::P1_ASSASSIN, healthPoints, boardIdx);
-        p1Pieces[ASSASSIN_PIECE_INDEX] = board[boardIdx];
-      } else if(s == "0warrior") {
-        board[boardIdx] = new Piece(PieceType::P1_WARRIOR, healthPoints, boardIdx);
-        p1Pieces[WARRIOR_PIECE_INDEX] = board[boardIdx];
-      } else if(s == "1king") {
-        board[boardIdx] = new Piece(PieceType::P2_KING, healthPoints, boardIdx);
-        p2Pieces[KING_PIECE_INDEX] = board[boardIdx];
-        p2King = board[boardIdx];
-      } else if(s == "1pawn") {
-        board[boardIdx] = new Piece(PieceType::P2_PAWN, healthPoints, boardIdx);
-        if(p2Pieces[PAWN_1_PIECE_INDEX]->healthPoints <= 0) {
-          p2Pieces[PAWN_1_PIECE_INDEX] = board[boardIdx];
-        } else if(p2Pieces[PAWN_2_PIECE_INDEX]->healthPoints <= 0) {
-          p2Pieces[PAWN_2_PIECE_INDEX] = board[boardIdx];
-        } else if(p2Pieces[PAWN_3_PIECE_INDEX]->healthPoints <= 0) {
-          p2Pieces[PAWN_3_PIECE_INDEX] = board[boardIdx];
-        } else {
-          throw "Already found 3 living PLAYER_2 Pawns";
-        }
-      } else if(s == "1mage") {
-        board[boardIdx] = new Piece(PieceType::P2_MAGE, healthPoints, boardIdx);
-        p2Pieces[MAGE_PIECE_INDEX] = board[boardIdx];
-      } else if(s == "1assassin") {
-        board[boardIdx] = new Piece(PieceType::P2_ASSASSIN, healthPoints, boardIdx);
-        p2Pieces[ASSASSIN_PIECE_INDEX] = board[boardIdx];
-      } else if(s == "1warrior") {
-        board[boardIdx] = new Piece(PieceType::P2_WARRIOR, healthPoints, boardIdx);
-        p2Pieces[WARRIOR_PIECE_INDEX] = board[boardIdx];
+  ParseError error = parseBoard(encodedBoard);
+  if(error != PARSE_OK) {
+    throw parseErrorToString(error);
+  }
+}
+
+/*
+ * Single pass over the text encoding, without allocating. The trailing comma is optional.
+ * Pieces that aren't on the board are dead.
+ */
+ParseError nichess::parseBoardPieces(std::string_view encodedBoard, Player& currentPlayer, Piece pieces[NUM_PLAYERS][NUM_STARTING_PIECES]) {
+  if(encodedBoard.size() < 2 || (encodedBoard[0] != '0' && encodedBoard[0] != '1') || encodedBoard[1] != '|') {
+    return PARSE_BAD_PLAYER;
+  }
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      pieces[p][i] = Piece(slotToPieceType[p][i], 0, 0);
+    }
+  }
+  size_t pos = 2;
+  int squareIndex = 0;
+  while(pos < encodedBoard.size()) {
+    if(squareIndex == NUM_SQUARES) return PARSE_BAD_SQUARE_COUNT;
+    size_t end = encodedBoard.find(',', pos);
+    if(end == std::string_view::npos) end = encodedBoard.size();
+    std::string_view token = encodedBoard.substr(pos, end - pos);
+    pos = end + 1;
+    int currentSquare = squareIndex++;
+    if(token == "empty") continue;
+
+    // <player>-<piece>-<health points>
+    if(token.size() < 5 || (token[0] != '0' && token[0] != '1') || token[1] != '-') return PARSE_BAD_TOKEN;
+    int player = token[0] - '0';
+    size_t nameEnd = token.find('-', 2);
+    if(nameEnd == std::string_view::npos) return PARSE_BAD_TOKEN;
+    std::string_view name = token.substr(2, nameEnd - 2);
+    std::string_view healthPointsText = token.substr(nameEnd + 1);
+    int healthPoints = 0;
+    auto [healthPointsEnd, ec] = std::from_chars(healthPointsText.data(), healthPointsText.data() + healthPointsText.size(), healthPoints);
+    if(ec != std::errc() || healthPointsEnd != healthPointsText.data() + healthPointsText.size() || healthPoints <= 0) {
+      return PARSE_BAD_HEALTH_POINTS;
+    }
+    int nameIndex = 0;
+    while(nameIndex <= PAWN_NAME && pieceNames[nameIndex] != name) {
+      nameIndex++;
+    }
+    if(nameIndex > PAWN_NAME) return PARSE_BAD_TOKEN;
+    int slot = pieceNameSlots[nameIndex];
+    // pawns take the first free pawn slot
+    if(nameIndex == PAWN_NAME) {
+      while(slot <= PAWN_3_PIECE_INDEX && pieces[player][slot].healthPoints > 0) {
+        slot++;
       }
+      if(slot > PAWN_3_PIECE_INDEX) return PARSE_TOO_MANY_PIECES;
+    } else if(pieces[player][slot].healthPoints > 0) {
+      return PARSE_TOO_MANY_PIECES;
+    }
+    pieces[player][slot].healthPoints = healthPoints;
+    pieces[player][slot].squareIndex = currentSquare;
+  }
+  if(squareIndex != NUM_SQUARES) return PARSE_BAD_SQUARE_COUNT;
+
+  currentPlayer = (Player) (encodedBoard[0] - '0');
+  return PARSE_OK;
+}
+
+/*
+ * Loads the position from the text encoding without allocating. On error the game is left
+ * unchanged.
+ */
+ParseError Game::parseBoard(std::string_view encodedBoard) {
+  Player parsedPlayer;
+  Piece parsed[NUM_PLAYERS][NUM_STARTING_PIECES];
+  ParseError error = parseBoardPieces(encodedBoard, parsedPlayer, parsed);
+  if(error != PARSE_OK) return error;
+  currentPlayer = parsedPlayer;
+  moveNumber = 0;
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      pieces[p][i] = parsed[p][i];
     }
-    b1.erase(0, pos + delimiter1.length());
-    boardIdx += 1;
   }
+  placePieces();
+  return PARSE_OK;
+}
+
+/*
+ * Writes the position into record without allocating. Health points above 1023 don't fit and are capped.
+ */
+void Game::encode(PositionRecord& record) const {
+  int moveNumberField = std::min(std::max(moveNumber, 0), 0xFFFF);
+  record.bytes[0] = (uint8_t) currentPlayer;
+  record.bytes[1] = 0;
+  record.bytes[2] = (uint8_t) (moveNumberField & 0xFF);
+  record.bytes[3] = (uint8_t) (moveNumberField >> 8);
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      const Piece& piece = pieces[p][i];
+      int healthPoints = std::min(std::max(piece.healthPoints, 0), 0x3FF);
+      int word = piece.squareIndex | (healthPoints << 6);
+      int offset = 4 + 2 * (p * NUM_STARTING_PIECES + i);
+      record.bytes[offset] = (uint8_t) (word & 0xFF);
+      record.bytes[offset + 1] = (uint8_t) (word >> 8);
+    }
+  }
+}
 
-  playerToPieces[PLAYER_1] = p1Pieces;
-  playerToPieces[PLAYER_2] = p2Pieces;
+/*
+ * Loads the position from record without allocating. Returns false and leaves the game
+ * unchanged if the record is malformed: unknown player, reserved byte set or two living
+ * pieces on the same square.
+ */
+bool Game::decode(const PositionRecord& record) {
+  if(record.bytes[0] >= NUM_PLAYERS || record.bytes[1] != 0) return false;
+  int squares[NUM_PLAYERS][NUM_STARTING_PIECES];
+  int healthPoints[NUM_PLAYERS][NUM_STARTING_PIECES];
+  uint64_t occupied = 0;
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      int offset = 4 + 2 * (p * NUM_STARTING_PIECES + i);
+      int word = record.bytes[offset] | (record.bytes[offset + 1] << 8);
+      squares[p][i] = word & 0x3F;
+      healthPoints[p][i] = word >> 6;
+      if(healthPoints[p][i] == 0) continue;
+      uint64_t mask = squareMask(squares[p][i]);
+      if(occupied & mask) return false;
+      occupied |= mask;
+    }
+  }
+  currentPlayer = (Player) record.bytes[0];
+  moveNumber = record.bytes[2] | (record.bytes[3] << 8);
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      pieces[p][i] = Piece(slotToPieceType[p][i], healthPoints[p][i], squares[p][i]);
+    }
+  }
+  placePieces();
+  return true;
 }
 
 std::vector<Piece*> Game::getAllPiecesByPlayer(Player player) {
-  return playerToPieces[player];
+  std::vector<Piece*> retval;
+  for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+    retval.push_back(&pieces[player][i]);
+  }
+  return retval;
 }
 
 /* 
  * performance test - https://www.chessprogramming.org/Perft
  * with bulk counting
  */
-unsigned long long nichess::perft(Game& game, int depth) {
+static unsigned long long perftRecursive(Game& game, int depth, ActionStack& actionStack) {
   unsigned long long nodes = 0;
-  std::vector<PlayerAction> legalActions = game.usefulLegalActions();
+  ActionList& legalActions = actionStack.at(depth);
+  game.usefulLegalActions(legalActions);
   int numLegalActions = legalActions.size();
   if(depth == 1) {
     return (unsigned long long) numLegalActions;
   }
 
   UndoInfo ui;
-  PlayerAction pa;
   for(int i = 0; i < numLegalActions; i++) {
     PlayerAction pa = legalActions[i];
     ui = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
-    nodes += perft(game, depth-1);
+    nodes += perftRecursive(game, depth-1, actionStack);
     game.undoAction(ui);
   }
   return nodes;
 }
+
+unsigned long long nichess::perft(Game& game, int depth) {
+  ActionStack actionStack = ActionStack(depth);
+  return perftRecursive(game, depth, actionStack);
+}
@@ -0,0 +1,266 @@
+#include "nichess/perft.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace nichess;
+
+namespace {
+
+/*
+ * One table slot. Depth is stored in the low 8 bits of data and the node count above it,
+ * an empty slot has depth 0 which is never stored.
+ */
+struct PerftEntry {
+  uint64_t key;
+  uint64_t data;
+};
+
+const int DEPTH_BITS = 8;
+const uint64_t DEPTH_MASK = (1ULL << DEPTH_BITS) - 1;
+
+/*
+ * Fixed-size, always-replace transposition table with a power of two number of entries.
+ */
+class PerftTable {
+  public:
+    PerftTable(size_t ttBytes) {
+      size_t numEntries = 1;
+      while(numEntries * 2 * sizeof(PerftEntry) <= ttBytes) {
+        numEntries *= 2;
+      }
+      if(numEntries * sizeof(PerftEntry) > ttBytes) numEntries = 0;
+      entries.resize(numEntries, PerftEntry{0, 0});
+      mask = numEntries > 0 ? numEntries - 1 : 0;
+    }
+
+    bool probe(uint64_t key, int depth, unsigned long long& nodes) const {
+      if(entries.empty()) return false;
+      const PerftEntry& entry = entries[index(key, depth)];
+      if(entry.key != key || (int)(entry.data & DEPTH_MASK) != depth) return false;
+      nodes = entry.data >> DEPTH_BITS;
+      return true;
+    }
+
+    void store(uint64_t key, int depth, unsigned long long nodes) {
+      if(entries.empty()) return;
+      entries[index(key, depth)] = PerftEntry{key, (nodes << DEPTH_BITS) | (uint64_t) depth};
+    }
+
+  private:
+    std::vector<PerftEntry> entries;
+    size_t mask;
+
+    // Same position at different depths goes to different slots
+    size_t index(uint64_t key, int depth) const {
+      return (size_t)(key ^ splitmix64(depth)) & mask;
+    }
+};
+
+unsigned long long perftHashedRecursive(Game& game, int depth, PerftTable& table, ActionStack& actionStack,
+    PerftResult& result) {
+  if(depth >= 2) {
+    unsigned long long nodes;
+    result.probes++;
+    if(table.probe(game.hash(), depth, nodes)) {
+      result.hits++;
+      return nodes;
+    }
+  }
+  ActionList& legalActions = actionStack.at(depth);
+  game.usefulLegalActions(legalActions);
+  int numLegalActions = legalActions.size();
+  if(depth == 1) {
+    return (unsigned long long) numLegalActions;
+  }
+
+  unsigned long long nodes = 0;
+  UndoInfo ui;
+  for(int i = 0; i < numLegalActions; i++) {
+    PlayerAction pa = legalActions[i];
+    ui = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    nodes += perftHashedRecursive(game, depth-1, table, actionStack, result);
+    game.undoAction(ui);
+  }
+  table.store(game.hash(), depth, nodes);
+  return nodes;
+}
+
+/*
+ * Subtree of the parallel perft: the actions leading to it from the root and the remaining depth.
+ */
+struct PerftTask {
+  std::vector<PlayerAction> path;
+  int depth;
+};
+
+/*
+ * The owner pushes and pops at the back, thieves take the oldest (and usually biggest)
+ * subtrees from the front.
+ */
+class WorkStealingDeque {
+  public:
+    void push(PerftTask task) {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+
+    bool pop(PerftTask& task) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(tasks.empty()) return false;
+      task = std::move(tasks.back());
+      tasks.pop_back();
+      return true;
+    }
+
+    bool steal(PerftTask& task) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(tasks.empty()) return false;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+      return true;
+    }
+
+  private:
+    std::mutex mutex;
+    std::deque<PerftTask> tasks;
+};
+
+class ParallelPerft {
+  public:
+    ParallelPerft(const Game& root, int numWorkers, int minSplitDepth):
+      root(root), numWorkers(numWorkers), minSplitDepth(minSplitDepth), maxDepth(0), deques(numWorkers),
+      nodes(0), pendingTasks(0), idleWorkers(0) { }
+
+    unsigned long long run(int depth) {
+      maxDepth = depth;
+      pushTask(0, PerftTask{std::vector<PlayerAction>(), depth});
+      std::vector<std::thread> threads;
+      for(int i = 0; i < numWorkers; i++) {
+        threads.emplace_back(&ParallelPerft::work, this, i);
+      }
+      for(std::thread& t: threads) {
+        t.join();
+      }
+      return nodes.load();
+    }
+
+  private:
+    const Game& root;
+    int numWorkers;
+    int minSplitDepth;
+    int maxDepth;
+    std::vector<WorkStealingDeque> deques;
+    std::atomic<unsigned long long> nodes;
+    // Tasks that are queued or being counted. Workers exit when it drops to 0.
+    std::atomic<long long> pendingTasks;
+    std::atomic<int> idleWorkers;
+
+    void pushTask(int worker, PerftTask task) {
+      pendingTasks.fetch_add(1);
+      deques[worker].push(std::move(task));
+    }
+
+    bool nextTask(int worker, PerftTask& task) {
+      if(deques[worker].pop(task)) return true;
+      idleWorkers.fetch_add(1);
+      while(true) {
+        for(int i = 1; i < numWorkers; i++) {
+          if(deques[(worker + i) % numWorkers].steal(task)) {
+            idleWorkers.fetch_sub(1);
+            return true;
+          }
+        }
+        if(pendingTasks.load() == 0) {
+          idleWorkers.fetch_sub(1);
+          return false;
+        }
+        std::this_thread::yield();
+      }
+    }
+
+    void work(int worker) {
+      Game game = Game(root);
+      ActionStack actionStack = ActionStack(maxDepth);
+      std::vector<UndoInfo> undoInfos;
+      PerftTask task;
+      while(nextTask(worker, task)) {
+        for(const PlayerAction& pa: task.path) {
+          undoInfos.push_back(game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx));
+        }
+        nodes.fetch_add(count(game, task.path, task.depth, actionStack, worker));
+        while(!undoInfos.empty()) {
+          game.undoAction(undoInfos.back());
+          undoInfos.pop_back();
+        }
+        pendingTasks.fetch_sub(1);
+      }
+    }
+
+    /*
+     * Serial perft that hands its remaining subtrees over as tasks when some worker is idle.
+     * Nodes of handed over subtrees are counted by whoever runs them.
+     */
+    unsigned long long count(Game& game, std::vector<PlayerAction>& path, int depth, ActionStack& actionStack,
+        int worker) {
+      ActionList& legalActions = actionStack.at(depth);
+      game.usefulLegalActions(legalActions);
+      int numLegalActions = legalActions.size();
+      if(depth == 1) {
+        return (unsigned long long) numLegalActions;
+      }
+
+      unsigned long long retval = 0;
+      UndoInfo ui;
+      for(int i = 0; i < numLegalActions; i++) {
+        PlayerAction pa = legalActions[i];
+        if(depth >= minSplitDepth && i + 1 < numLegalActions && idleWorkers.load(std::memory_order_relaxed) > 0) {
+          for(int j = numLegalActions - 1; j >= i; j--) {
+            path.push_back(legalActions[j]);
+            pushTask(worker, PerftTask{path, depth-1});
+            path.pop_back();
+          }
+          break;
+        }
+        ui = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+        path.push_back(pa);
+        retval += count(game, path, depth-1, actionStack, worker);
+        path.pop_back();
+        game.undoAction(ui);
+      }
+      return retval;
+    }
+};
+
+} // namespace
+
+PerftResult::PerftResult(): nodes(0), probes(0), hits(0) { }
+
+double PerftResult::hitRate() const {
+  if(probes == 0) return 0;
+  return (double) hits / (double) probes;
+}
+
+PerftResult nichess::perftHashed(Game& game, int depth, size_t ttBytes) {
+  PerftResult result;
+  if(depth < 1) return result;
+  PerftTable table = PerftTable(ttBytes);
+  ActionStack actionStack = ActionStack(depth);
+  result.nodes = perftHashedRecursive(game, depth, table, actionStack, result);
+  return result;
+}
+
+unsigned long long nichess::perftParallel(const Game& game, int depth, int numThreads, int minSplitDepth) {
+  if(numThreads <= 0) {
+    numThreads = std::max(1, (int) std::thread::hardware_concurrency());
+  }
+  // children of a split node need at least depth 1
+  minSplitDepth = std::max(2, minSplitDepth);
+  if(depth < 1) return 0;
+  ParallelPerft parallelPerft = ParallelPerft(game, numThreads, minSplitDepth);
+  return parallelPerft.run(depth);
+}
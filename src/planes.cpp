@@ -0,0 +1,84 @@
+#include "nichess/planes.hpp"
+
+#include <cmath>
+#include <cstring>
+
+using namespace nichess;
+
+static const int NUM_SLOTS = NUM_PLAYERS * NUM_STARTING_PIECES;
+
+template<typename T> static T planeOne();
+template<> float planeOne<float>() { return 1.0f; }
+template<> int8_t planeOne<int8_t>() { return INT8_PLANE_ONE; }
+
+template<typename T> static T healthPointsValue(int healthPoints);
+template<> float healthPointsValue<float>(int healthPoints) {
+  return (float) healthPoints / HEALTH_POINTS_SCALE;
+}
+template<> int8_t healthPointsValue<int8_t>(int healthPoints) {
+  return (int8_t) std::lround((double) healthPoints * INT8_PLANE_ONE / HEALTH_POINTS_SCALE);
+}
+
+template<typename T>
+void nichess::encodePlanes(const PieceType* types, const int* squareIndices, const int* healthPoints, Player currentPlayer,
+    bool sideToMove, T* out) {
+  std::memset(out, 0, sizeof(T) * INPUT_PLANES_SIZE);
+  bool flip = sideToMove && currentPlayer == PLAYER_2;
+  for(int slot = 0; slot < NUM_SLOTS; slot++) {
+    if(healthPoints[slot] <= 0) continue;
+    int square = squareIndices[slot];
+    int plane = types[slot];
+    if(flip) {
+      square = (NUM_ROWS - 1 - square / NUM_COLUMNS) * NUM_COLUMNS + square % NUM_COLUMNS;
+      plane = (plane + NUM_PIECE_PLANES / 2) % NUM_PIECE_PLANES;
+    }
+    out[plane * NUM_SQUARES + square] = planeOne<T>();
+    out[HEALTH_POINTS_PLANE * NUM_SQUARES + square] = healthPointsValue<T>(healthPoints[slot]);
+  }
+  if(currentPlayer == PLAYER_2) {
+    T* playerPlane = out + PLAYER_PLANE * NUM_SQUARES;
+    for(int i = 0; i < NUM_SQUARES; i++) {
+      playerPlane[i] = planeOne<T>();
+    }
+  }
+}
+
+template void nichess::encodePlanes<float>(const PieceType*, const int*, const int*, Player, bool, float*);
+template void nichess::encodePlanes<int8_t>(const PieceType*, const int*, const int*, Player, bool, int8_t*);
+
+template<typename T>
+static void encodeGame(const Game& game, T* out, bool sideToMove) {
+  PieceType types[NUM_SLOTS];
+  int squareIndices[NUM_SLOTS];
+  int healthPoints[NUM_SLOTS];
+  for(int p = 0; p < NUM_PLAYERS; p++) {
+    for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+      const Piece* piece = game.playerPiece((Player) p, i);
+      int slot = p * NUM_STARTING_PIECES + i;
+      types[slot] = piece->type;
+      squareIndices[slot] = piece->squareIndex;
+      healthPoints[slot] = piece->healthPoints;
+    }
+  }
+  encodePlanes(types, squareIndices, healthPoints, game.currentPlayer, sideToMove, out);
+}
+
+void nichess::encodePlanes(const Game& game, float* out, bool sideToMove) {
+  encodeGame(game, out, sideToMove);
+}
+
+void nichess::encodePlanes(const Game& game, int8_t* out, bool sideToMove) {
+  encodeGame(game, out, sideToMove);
+}
+
+void nichess::encodePlanes(const Game* games, int numGames, float* out, bool sideToMove) {
+  for(int i = 0; i < numGames; i++) {
+    encodeGame(games[i], out + (size_t) i * INPUT_PLANES_SIZE, sideToMove);
+  }
+}
+
+void nichess::encodePlanes(const Game* games, int numGames, int8_t* out, bool sideToMove) {
+  for(int i = 0; i < numGames; i++) {
+    encodeGame(games[i], out + (size_t) i * INPUT_PLANES_SIZE, sideToMove);
+  }
+}
@@ -0,0 +1,161 @@
+#include "nichess/search.hpp"
+#include "nichess/evaluate.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace nichess;
+
+// Bigger than any score, including wins
+static const int INFINITE_SCORE = WIN_SCORE + 1;
+// Aspiration window half-width at the start of each iteration
+static const int ASPIRATION_WINDOW = 50;
+// Budget is checked every this many nodes
+static const unsigned long long NODES_BETWEEN_CHECKS = 1024;
+
+static bool sameAction(const PlayerAction& a1, const PlayerAction& a2) {
+  return a1.moveSrcIdx == a2.moveSrcIdx && a1.moveDstIdx == a2.moveDstIdx &&
+    a1.abilitySrcIdx == a2.abilitySrcIdx && a1.abilityDstIdx == a2.abilityDstIdx;
+}
+
+SearchLimits::SearchLimits(): maxDepth(0), maxNodes(0), maxSeconds(0) { }
+
+SearchResult::SearchResult():
+  bestAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP),
+  score(0),
+  depth(0),
+  nodes(0)
+{ }
+
+Search::Search(): actionStack(MAX_SEARCH_PLY) { }
+
+SearchResult Search::search(Game& game, const SearchLimits& limits) {
+  SearchResult result;
+  nodes = 0;
+  maxNodes = limits.maxNodes;
+  timeLimited = limits.maxSeconds > 0;
+  deadline = std::chrono::steady_clock::now() +
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limits.maxSeconds));
+  nextTimeCheck = NODES_BETWEEN_CHECKS;
+  stopped = false;
+  previousPv.clear();
+  if(game.gameOver()) {
+    return result;
+  }
+
+  int maxDepth = limits.maxDepth > 0 ? std::min(limits.maxDepth, MAX_SEARCH_PLY) : MAX_SEARCH_PLY;
+  int previousScore = 0;
+  for(int depth = 1; depth <= maxDepth; depth++) {
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -INFINITE_SCORE;
+    int beta = INFINITE_SCORE;
+    if(depth >= 3) {
+      alpha = std::max(previousScore - delta, -INFINITE_SCORE);
+      beta = std::min(previousScore + delta, INFINITE_SCORE);
+    }
+    int score;
+    while(true) {
+      score = negamax(game, depth, alpha, beta, 0);
+      if(stopped) break;
+      // widen the window on the side that failed
+      if(score <= alpha && alpha > -INFINITE_SCORE) {
+        delta *= 4;
+        alpha = std::max(score - delta, -INFINITE_SCORE);
+      } else if(score >= beta && beta < INFINITE_SCORE) {
+        delta *= 4;
+        beta = std::min(score + delta, INFINITE_SCORE);
+      } else {
+        break;
+      }
+    }
+    if(stopped) break;
+
+    previousScore = score;
+    previousPv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+    result.bestAction = previousPv[0];
+    result.score = score;
+    result.depth = depth;
+    result.pv = previousPv;
+    // no point searching deeper once a forced result is found
+    if(std::abs(score) >= WIN_SCORE - MAX_SEARCH_PLY) break;
+  }
+  result.nodes = nodes;
+  return result;
+}
+
+bool Search::outOfBudget() {
+  if(maxNodes > 0 && nodes >= maxNodes) return true;
+  if(timeLimited && nodes >= nextTimeCheck) {
+    nextTimeCheck = nodes + NODES_BETWEEN_CHECKS;
+    if(std::chrono::steady_clock::now() >= deadline) return true;
+  }
+  return false;
+}
+
+int Search::negamax(Game& game, int depth, int alpha, int beta, int ply) {
+  pvLength[ply] = 0;
+  nodes++;
+  // only the side that just moved can have killed a king
+  if(game.gameOver()) {
+    return game.winner() == game.currentPlayer ? WIN_SCORE - ply : -(WIN_SCORE - ply);
+  }
+  if(depth == 0 || ply == MAX_SEARCH_PLY) {
+    return evaluate(game);
+  }
+  // the root doesn't check and children of depth 1 are leaves, so depth 1 always completes
+  if(ply > 0 && outOfBudget()) {
+    stopped = true;
+    return 0;
+  }
+
+  ActionList& actions = actionStack.at(ply);
+  game.usefulLegalActions(actions);
+  orderActions(actions, ply);
+  int bestScore = -INFINITE_SCORE;
+  for(int i = 0; i < actions.size(); i++) {
+    PlayerAction pa = actions[i];
+    UndoInfo ui = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    int score;
+    if(i == 0) {
+      score = -negamax(game, depth - 1, -beta, -alpha, ply + 1);
+    } else {
+      // null window search, re-search if it turns out better than the current best
+      score = -negamax(game, depth - 1, -alpha - 1, -alpha, ply + 1);
+      if(score > alpha && score < beta && !stopped) {
+        score = -negamax(game, depth - 1, -beta, -alpha, ply + 1);
+      }
+    }
+    game.undoAction(ui);
+    if(stopped) return 0;
+
+    if(score > bestScore) {
+      bestScore = score;
+      pvTable[ply][0] = pa;
+      for(int j = 0; j < pvLength[ply + 1]; j++) {
+        pvTable[ply][j + 1] = pvTable[ply + 1][j];
+      }
+      pvLength[ply] = pvLength[ply + 1] + 1;
+      if(score > alpha) {
+        alpha = score;
+        if(alpha >= beta) break;
+      }
+    }
+  }
+  return bestScore;
+}
+
+/*
+ * Previous PV action first, then actions that use an ability. Done in place, without allocating.
+ */
+void Search::orderActions(ActionList& actions, int ply) const {
+  PlayerAction* first = actions.begin();
+  if(ply < (int) previousPv.size()) {
+    PlayerAction* pvAction = std::find_if(actions.begin(), actions.end(),
+        [&](const PlayerAction& pa) { return sameAction(pa, previousPv[ply]); });
+    if(pvAction != actions.end()) {
+      std::rotate(first, pvAction, pvAction + 1);
+      first++;
+    }
+  }
+  std::partition(first, actions.end(), [](const PlayerAction& pa) { return pa.abilitySrcIdx != ABILITY_SKIP; });
+}
@@ -0,0 +1,141 @@
+#include "nichess/nichess.hpp"
+#include "nichess/actionindex.hpp"
+#include "nichess/bitboard.hpp"
+#include "nichess/generator.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME, LEGAL_ACTIONS_2};
+
+static bool sameAction(const PlayerAction& a1, const PlayerAction& a2) {
+  return a1.moveSrcIdx == a2.moveSrcIdx && a1.moveDstIdx == a2.moveDstIdx &&
+    a1.abilitySrcIdx == a2.abilitySrcIdx && a1.abilityDstIdx == a2.abilityDstIdx;
+}
+
+/*
+ * indexToAction and actionIndex are inverses over the whole index space
+ */
+int actionIndexTest1() {
+  for(int index = 0; index < NUM_ACTION_INDICES; index++) {
+    if(actionIndex(indexToAction(index)) != index) return -1;
+  }
+  // every pair a piece can use on an empty board has an index
+  for(int sq = 0; sq < NUM_SQUARES; sq++) {
+    for(int table = 0; table < NO_MOVES; table++) {
+      for(uint64_t targets = moveTable.masks[table][sq]; targets != 0; targets &= targets - 1) {
+        if(moveIndex(sq, lsbIndex(targets)) < 0) return -1;
+      }
+    }
+    for(int table = 0; table < NO_ABILITIES; table++) {
+      for(uint64_t targets = abilityTable.masks[table][sq]; targets != 0; targets &= targets - 1) {
+        if(abilityIndex(sq, lsbIndex(targets)) < 0) return -1;
+      }
+    }
+  }
+  if(moveIndex(0, 63) != -1 || abilityIndex(0, 0) != -1) return -1;
+  return 0;
+}
+
+/*
+ * Moves of the mask match its rows, move skip is row 0
+ */
+static bool consistentRows(const ActionMask& mask) {
+  int numMoveBits = 0;
+  for(int w = 0; w < MOVE_MASK_WORDS; w++) {
+    numMoveBits += popCount(mask.moves[w]);
+  }
+  if(numMoveBits != mask.numMoves || (mask.numMoves > 0 && mask.moveIndices[0] != MOVE_SKIP_INDEX)) return false;
+  for(int k = 0; k < mask.numMoves; k++) {
+    int move = mask.moveIndices[k];
+    if(!((mask.moves[move / 64] >> (move % 64)) & 1)) return false;
+  }
+  return true;
+}
+
+/*
+ * Legal action mask has exactly the useful legal actions, during whole games
+ */
+int actionIndexTest2() {
+  GameCache cache = GameCache();
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0]), Game(cache, testPositions[1]), Game(cache, testPositions[2])};
+  ActionMask mask;
+  auto check = [&](Game& g, const std::vector<PlayerAction>& useful) {
+    for(const PlayerAction& pa: useful) {
+      int index = actionIndex(pa);
+      if(index < 0 || !sameAction(indexToAction(index), pa)) return false;
+    }
+    std::memset(&mask, 0xff, sizeof(mask));
+    legalActionMask(g, mask);
+    if(!consistentRows(mask) || mask.numActions() != (int) useful.size()) return false;
+    for(const PlayerAction& pa: useful) {
+      if(!mask.contains(pa)) return false;
+    }
+    return true;
+  };
+  for(Game& g: games) {
+    if(!playSeededGame(g, 60, check)) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Every set bit of the mask decodes to a legal action, the mask is empty once the game is over
+ */
+int actionIndexTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[0]);
+  ActionMask mask;
+  legalActionMask(g, mask);
+  int count = 0;
+  for(int k = 0; k < mask.numMoves; k++) {
+    for(int w = 0; w < ABILITY_MASK_WORDS; w++) {
+      for(uint64_t bits = mask.abilities[k][w]; bits != 0; bits &= bits - 1) {
+        PlayerAction pa = indexToAction(mask.moveIndices[k] * NUM_ABILITY_INDICES + w * 64 + lsbIndex(bits));
+        if(!g.isActionLegal(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx)) return -1;
+        count++;
+      }
+    }
+  }
+  if(count != (int) g.usefulLegalActions().size()) return -1;
+
+  // player 1 king kills the player 2 king
+  Game over = Game(cache, "0|0-king-140,1-king-10,empty,empty,empty,empty,empty,empty,empty,0-pawn-210,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,");
+  over.makeAction(MOVE_SKIP, MOVE_SKIP, 0, 1);
+  if(!over.gameOver()) return -1;
+  legalActionMask(over, mask);
+  if(mask.numMoves != 0 || !consistentRows(mask)) return -1;
+  return 0;
+}
+
+int actionindextest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return actionIndexTest1();
+  case 2:
+    return actionIndexTest2();
+  case 3:
+    return actionIndexTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,23 @@
+#include "testutil.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new of the whole test runner, library included, so that tests
+// can check that a piece of code doesn't allocate.
+std::atomic<unsigned long long> numAllocations(0);
+
+void* operator new(std::size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if(p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
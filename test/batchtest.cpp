@@ -0,0 +1,142 @@
+#include "nichess/nichess.hpp"
+#include "nichess/batch.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {WARRIOR_KILLS_KING};
+
+/*
+ * Stepping the batch gives the same games as stepping separate Game objects
+ */
+int batchTest1() {
+  GameCache cache = GameCache();
+  const int numGames = 16;
+  GameBatch batch = GameBatch(cache, numGames);
+  std::vector<Game> games(numGames, Game(cache));
+  Game loaded = Game(cache);
+  std::vector<PlayerAction> actions(numGames);
+  std::vector<uint8_t> over(numGames);
+  std::vector<int8_t> winners(numGames);
+  for(int ply = 0; ply < 60; ply++) {
+    for(int i = 0; i < numGames; i++) {
+      if(!games[i].gameOver()) {
+        actions[i] = seededAction(games[i].usefulLegalActions(), ply, i);
+        games[i].makeAction(actions[i].moveSrcIdx, actions[i].moveDstIdx, actions[i].abilitySrcIdx, actions[i].abilityDstIdx);
+      }
+    }
+    batch.step(actions.data());
+    batch.gameOver(over.data());
+    batch.winner(winners.data());
+    for(int i = 0; i < numGames; i++) {
+      batch.load(i, loaded);
+      if(loaded.boardToString() != games[i].boardToString() || loaded.hash() != games[i].hash()) return -1;
+      if(loaded.moveNumber != games[i].moveNumber) return -1;
+      if(over[i] != (games[i].gameOver() ? 1 : 0)) return -1;
+      int expectedWinner = games[i].gameOver() ? (int) games[i].winner().value() : -1;
+      if(winners[i] != expectedWinner) return -1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Reset only touches the masked games, finished games ignore steps
+ */
+int batchTest2() {
+  GameCache cache = GameCache();
+  GameBatch batch = GameBatch(cache, 3);
+  Game won = Game(cache, testPositions[0]);
+  won.makeAction(27, 35, 35, 36);
+  if(!won.gameOver()) return -1;
+  batch.store(0, won);
+  batch.store(1, Game(cache, testPositions[0]));
+  batch.store(2, Game(cache, testPositions[0]));
+
+  PlayerAction actions[3] = {
+    PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP),
+    PlayerAction(27, 35, 35, 36),
+    PlayerAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP)
+  };
+  batch.step(actions);
+  uint8_t over[3];
+  int8_t winners[3];
+  uint8_t players[3];
+  batch.gameOver(over);
+  batch.winner(winners);
+  batch.currentPlayers(players);
+  if(over[0] != 1 || over[1] != 1 || over[2] != 0) return -1;
+  if(winners[0] != PLAYER_1 || winners[1] != PLAYER_1 || winners[2] != -1) return -1;
+  // the finished game didn't change side
+  if(players[0] != PLAYER_2 || players[1] != PLAYER_2 || players[2] != PLAYER_2) return -1;
+
+  uint8_t mask[3] = {1, 0, 1};
+  batch.reset(mask);
+  batch.gameOver(over);
+  Game loaded = Game(cache);
+  std::string opening = Game(cache).boardToString();
+  batch.load(0, loaded);
+  if(loaded.boardToString() != opening || loaded.moveNumber != 0) return -1;
+  batch.load(2, loaded);
+  if(loaded.boardToString() != opening) return -1;
+  if(over[0] != 0 || over[1] != 1 || over[2] != 0) return -1;
+  return 0;
+}
+
+/*
+ * Legal action masks have exactly the useful legal actions, finished games have none
+ */
+int batchTest3() {
+  GameCache cache = GameCache();
+  GameBatch batch = GameBatch(cache, 3);
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0]), Game(cache, testPositions[0])};
+  games[2].makeAction(27, 35, 35, 36);
+  for(int i = 0; i < 3; i++) {
+    batch.store(i, games[i]);
+  }
+  std::vector<ActionMask> masks(3);
+  batch.legalActionMasks(masks.data());
+  for(int i = 0; i < 3; i++) {
+    const ActionMask& mask = masks[i];
+    if(games[i].gameOver()) {
+      if(mask.numMoves != 0 || mask.numActions() != 0) return -1;
+      continue;
+    }
+    std::vector<PlayerAction> actions = games[i].usefulLegalActions();
+    if(mask.numActions() != (int) actions.size()) return -1;
+    for(const PlayerAction& pa: actions) {
+      if(!mask.contains(pa)) return -1;
+    }
+  }
+  return 0;
+}
+
+int batchtest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return batchTest1();
+  case 2:
+    return batchTest2();
+  case 3:
+    return batchTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
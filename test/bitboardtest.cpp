@@ -0,0 +1,141 @@
+#include "nichess/nichess.hpp"
+#include "nichess/bitboard.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {FULL_ARMIES, LEGAL_ACTIONS_1, LEGAL_ACTIONS_2, MIDDLEGAME};
+
+static bool sameActions(std::vector<PlayerAction> a1, std::vector<PlayerAction> a2) {
+  auto key = [](const PlayerAction& pa) {
+    return std::make_tuple(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  };
+  auto cmp = [&key](const PlayerAction& x, const PlayerAction& y) { return key(x) < key(y); };
+  if(a1.size() != a2.size()) return false;
+  std::sort(a1.begin(), a1.end(), cmp);
+  std::sort(a2.begin(), a2.end(), cmp);
+  for(size_t i = 0; i < a1.size(); i++) {
+    if(key(a1[i]) != key(a2[i])) return false;
+  }
+  return true;
+}
+
+/*
+ * Same action counts as in legalactionstest
+ */
+int bitboardTest1() {
+  GameCache cache = GameCache();
+  BitboardGame g = BitboardGame(cache);
+  if(g.usefulLegalActions().size() != 42) return -1;
+  if(g.allLegalActions().size() != 1886) return -1;
+
+  g.boardFromString(testPositions[1]);
+  if(g.usefulLegalActions().size() != 84) return -1;
+
+  g.boardFromString(testPositions[2]);
+  if(g.usefulLegalActions().size() != 46) return -1;
+  return 0;
+}
+
+/*
+ * Perft parity with Game
+ */
+int bitboardTest2() {
+  GameCache cache = GameCache();
+  for(const std::string& position: testPositions) {
+    Game g1 = Game(cache, position);
+    BitboardGame g2 = BitboardGame(cache, position);
+    for(int depth = 1; depth <= 3; depth++) {
+      if(perft(g1, depth) != perft(g2, depth)) return -1;
+    }
+  }
+  Game g1 = Game(cache);
+  BitboardGame g2 = BitboardGame(cache);
+  if(perft(g2, 3) != perft(g1, 3)) return -1;
+  return 0;
+}
+
+/*
+ * Plays the same game on Game and BitboardGame and compares positions and action lists,
+ * then undoes everything.
+ */
+int bitboardTest3() {
+  GameCache cache = GameCache();
+  for(const std::string& position: testPositions) {
+    Game g1 = Game(cache, position);
+    BitboardGame g2 = BitboardGame(cache, position);
+    std::vector<UndoInfo> undo1;
+    std::vector<BitboardUndoInfo> undo2;
+    for(int ply = 0; ply < 60 && !g1.gameOver(); ply++) {
+      std::vector<PlayerAction> a1 = g1.usefulLegalActions();
+      if(!sameActions(a1, g2.usefulLegalActions())) return -1;
+      if(!sameActions(g1.allLegalActions(), g2.allLegalActions())) return -1;
+      PlayerAction pa = seededAction(a1, ply);
+      undo1.push_back(g1.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx));
+      undo2.push_back(g2.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx));
+      if(g1.boardToString() != g2.boardToString()) return -1;
+      if(g1.gameOver() != g2.gameOver()) return -1;
+    }
+    while(!undo1.empty()) {
+      g1.undoAction(undo1.back());
+      g2.undoAction(undo2.back());
+      undo1.pop_back();
+      undo2.pop_back();
+      if(g1.boardToString() != g2.boardToString()) return -1;
+    }
+    if(g2.boardToString() != position) return -1;
+  }
+  return 0;
+}
+
+/*
+ * BitboardGame uses Game's parser: same errors, and the game is unchanged on error
+ */
+int bitboardTest4() {
+  GameCache cache = GameCache();
+  const std::string badBoards[] = {"", "2|", "0|0-queen-100,", "0|0-king-0,", "0|0-king-200,0-king-200,", "0|empty,"};
+  BitboardGame g = BitboardGame(cache, MIDDLEGAME);
+  Game reference = Game(cache);
+  for(const std::string& board: badBoards) {
+    if(g.parseBoard(board) == PARSE_OK || g.parseBoard(board) != reference.parseBoard(board)) return -1;
+    if(g.boardToString() != MIDDLEGAME) return -1;
+  }
+  try {
+    g.boardFromString(badBoards[2]);
+    return -1;
+  } catch(const char*) { }
+  return g.parseBoard(FULL_ARMIES) == PARSE_OK && g.boardToString() == FULL_ARMIES ? 0 : -1;
+}
+
+int bitboardtest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return bitboardTest1();
+  case 2:
+    return bitboardTest2();
+  case 3:
+    return bitboardTest3();
+  case 4:
+    return bitboardTest4();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,123 @@
+#include "nichess/nichess.hpp"
+#include "nichess/evaluate.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME};
+
+/*
+ * During games with kills the evaluation changes sign with the player to move, accumulators
+ * match the ones computed from scratch, and each kill takes exactly the value of the killed
+ * pieces off the material of their owner.
+ */
+int evaluateTest1() {
+  GameCache cache = GameCache();
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0]), Game(cache, testPositions[1])};
+  int numKills = 0;
+  for(Game& g: games) {
+    std::vector<UndoInfo> undoInfos;
+    Game previous = g;
+    auto check = [&](Game& game, const std::vector<PlayerAction>&) {
+      if(game.accumulators() != game.computeAccumulators()) return false;
+      Game passed = game;
+      passed.makeAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+      if(evaluate(passed) != -evaluate(game)) return false;
+      if(!undoInfos.empty()) {
+        // pieces of the player to move were hit by the last action
+        Player victim = game.currentPlayer;
+        int killedValue = 0;
+        for(int slot = 0; slot < NUM_STARTING_PIECES; slot++) {
+          if((undoInfos.back().killedSlots >> slot) & 1) {
+            killedValue += pieceTypeToValue[game.playerPiece(victim, slot)->type];
+            numKills++;
+          }
+        }
+        const Accumulators& before = previous.accumulators();
+        const Accumulators& after = game.accumulators();
+        if(before.material[victim] - after.material[victim] != killedValue) return false;
+        if(before.material[~victim] != after.material[~victim]) return false;
+      }
+      previous = game;
+      return true;
+    };
+    if(!playSeededGame(g, 80, check, &undoInfos)) return -1;
+  }
+  return numKills > 0 ? 0 : -1;
+}
+
+/*
+ * Evaluation of known positions, and it changes sign with the player to move
+ */
+int evaluateTest2() {
+  GameCache cache = GameCache();
+  Game opening = Game(cache);
+  if(evaluate(opening) != 0) return -1;
+
+  Game g = Game(cache, testPositions[0]);
+  const Accumulators& accumulators = g.accumulators();
+  if(accumulators.healthPoints[PLAYER_1] != 460 || accumulators.healthPoints[PLAYER_2] != 380) return -1;
+  if(accumulators.material[PLAYER_1] != 250 || accumulators.material[PLAYER_2] != 150) return -1;
+  // player 2 pawn next to player 1 king
+  if(accumulators.kingZonePieces[PLAYER_1] != 1 || accumulators.kingZonePieces[PLAYER_2] != 0) return -1;
+  int score = evaluate(g);
+  if(score != 80 + 100 - KING_ZONE_WEIGHT) return -1;
+  g.makeAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  if(evaluate(g) != -score) return -1;
+  return 0;
+}
+
+/*
+ * Killing a piece next to the enemy king and moving the king update the accumulators
+ */
+int evaluateTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[0]);
+  // player 1 king kills the pawn next to it
+  UndoInfo ui = g.makeAction(MOVE_SKIP, MOVE_SKIP, 0, 1);
+  const Accumulators& accumulators = g.accumulators();
+  if(accumulators.kingZonePieces[PLAYER_1] != 0 || accumulators.healthPoints[PLAYER_2] != 370 ||
+      accumulators.material[PLAYER_2] != 100) {
+    return -1;
+  }
+  g.undoAction(ui);
+  if(accumulators.kingZonePieces[PLAYER_1] != 1 || accumulators.healthPoints[PLAYER_2] != 380) return -1;
+  // king steps away from the pawn
+  g.makeAction(0, 8, ABILITY_SKIP, ABILITY_SKIP);
+  if(accumulators.kingZonePieces[PLAYER_1] != 1) return -1;
+  g.makeAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  g.makeAction(8, 16, ABILITY_SKIP, ABILITY_SKIP);
+  if(accumulators.kingZonePieces[PLAYER_1] != 0) return -1;
+  if(accumulators != g.computeAccumulators()) return -1;
+  return 0;
+}
+
+int evaluatetest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return evaluateTest1();
+  case 2:
+    return evaluateTest2();
+  case 3:
+    return evaluateTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,144 @@
+#include "nichess/nichess.hpp"
+#include "nichess/generator.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME, LEGAL_ACTIONS_2};
+
+static std::vector<std::tuple<int, int, int, int>> sortedActions(const std::vector<PlayerAction>& actions) {
+  std::vector<std::tuple<int, int, int, int>> retval;
+  for(const PlayerAction& pa: actions) {
+    retval.push_back(std::make_tuple(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx));
+  }
+  std::sort(retval.begin(), retval.end());
+  return retval;
+}
+
+static std::vector<PlayerAction> generateAll(const Game& game) {
+  std::vector<PlayerAction> retval;
+  ActionGenerator generator = ActionGenerator(game);
+  PlayerAction pa;
+  while(generator.next(pa)) {
+    retval.push_back(pa);
+  }
+  return retval;
+}
+
+/*
+ * Generator yields exactly the useful legal actions, during a whole game
+ */
+int generatorTest1() {
+  GameCache cache = GameCache();
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0]), Game(cache, testPositions[1]), Game(cache, testPositions[2])};
+  auto check = [](Game& g, const std::vector<PlayerAction>& useful) {
+    return sortedActions(useful) == sortedActions(generateAll(g));
+  };
+  for(Game& g: games) {
+    if(!playSeededGame(g, 60, check)) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Actions come in stage order and the skip action comes last
+ */
+int generatorTest2() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[1]);
+  ActionGenerator generator = ActionGenerator(g);
+  if(generator.stage() != ActionGenerator::ABILITIES) return -1;
+  PlayerAction pa;
+  int previousStage = ActionGenerator::ABILITIES;
+  int numActions = 0;
+  while(generator.next(pa)) {
+    numActions++;
+    int stage = generator.stage();
+    if(stage < previousStage) return -1;
+    previousStage = stage;
+    bool moveSkipped = pa.moveSrcIdx == MOVE_SKIP;
+    bool abilitySkipped = pa.abilitySrcIdx == ABILITY_SKIP;
+    switch(stage) {
+      case ActionGenerator::ABILITIES:
+        if(!moveSkipped || abilitySkipped) return -1;
+        break;
+      case ActionGenerator::MOVES_WITH_ABILITIES:
+        if(moveSkipped || abilitySkipped) return -1;
+        break;
+      case ActionGenerator::PLAIN_MOVES:
+        if(moveSkipped || !abilitySkipped) return -1;
+        break;
+      case ActionGenerator::SKIP:
+        if(!moveSkipped || !abilitySkipped) return -1;
+        break;
+      default:
+        return -1;
+    }
+  }
+  if(previousStage != ActionGenerator::SKIP) return -1;
+  if(generator.stage() != ActionGenerator::DONE || generator.next(pa)) return -1;
+  if(numActions != (int) g.usefulLegalActions().size()) return -1;
+
+  // dead king means no actions
+  Game g2 = Game(cache, testPositions[1]);
+  g2.makeAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  g2.playerPiece(PLAYER_1, KING_PIECE_INDEX)->healthPoints = 0;
+  ActionGenerator generator2 = ActionGenerator(g2);
+  if(generator2.next(pa)) return -1;
+  return 0;
+}
+
+/*
+ * Abandoning a generator doesn't change the game, and reset starts over
+ */
+int generatorTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[2]);
+  std::string original = g.boardToString();
+  ActionGenerator generator = ActionGenerator(g);
+  PlayerAction first, pa;
+  if(!generator.next(first)) return -1;
+  for(int i = 0; i < 10; i++) {
+    if(!generator.next(pa)) return -1;
+  }
+  if(g.boardToString() != original) return -1;
+  generator.reset();
+  if(!generator.next(pa)) return -1;
+  if(pa.moveSrcIdx != first.moveSrcIdx || pa.moveDstIdx != first.moveDstIdx ||
+      pa.abilitySrcIdx != first.abilitySrcIdx || pa.abilityDstIdx != first.abilityDstIdx) {
+    return -1;
+  }
+  return 0;
+}
+
+int generatortest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return generatorTest1();
+  case 2:
+    return generatorTest2();
+  case 3:
+    return generatorTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,107 @@
+#include "nichess/nichess.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME};
+
+/*
+ * Incremental hash matches the one computed from scratch during a game with kills,
+ * and undoing every action restores the original hash.
+ */
+int hashTest1() {
+  GameCache cache = GameCache();
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0]), Game(cache, testPositions[1])};
+  for(Game& g: games) {
+    uint64_t originalHash = g.hash();
+    if(originalHash != g.computeHash()) return -1;
+    std::vector<UndoInfo> undoInfos;
+    auto check = [](Game& game, const std::vector<PlayerAction>&) { return game.hash() == game.computeHash(); };
+    if(!playSeededGame(g, 80, check, &undoInfos)) return -1;
+    while(!undoInfos.empty()) {
+      g.undoAction(undoInfos.back());
+      undoInfos.pop_back();
+      if(g.hash() != g.computeHash()) return -1;
+    }
+    if(g.hash() != originalHash) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Same position reached by different move orders has the same hash, also after
+ * copying the game or loading it from its string encoding.
+ */
+int hashTest2() {
+  GameCache cache = GameCache();
+  Game g1 = Game(cache);
+  Game g2 = Game(cache);
+  g1.makeAction(8, 16, ABILITY_SKIP, ABILITY_SKIP);
+  g1.makeAction(50, 42, ABILITY_SKIP, ABILITY_SKIP);
+  g1.makeAction(9, 17, ABILITY_SKIP, ABILITY_SKIP);
+  g2.makeAction(9, 17, ABILITY_SKIP, ABILITY_SKIP);
+  g2.makeAction(50, 42, ABILITY_SKIP, ABILITY_SKIP);
+  g2.makeAction(8, 16, ABILITY_SKIP, ABILITY_SKIP);
+  if(g1.boardToString() != g2.boardToString()) return -1;
+  if(g1.hash() != g2.hash()) return -1;
+
+  Game g3 = Game(g1);
+  if(g3.hash() != g1.hash()) return -1;
+  Game g4 = Game(cache, g1.boardToString());
+  if(g4.hash() != g1.hash()) return -1;
+  g4.reset();
+  if(g4.hash() != Game(cache).hash()) return -1;
+  return 0;
+}
+
+/*
+ * Side to move and health points are part of the hash.
+ */
+int hashTest3() {
+  GameCache cache = GameCache();
+  std::string position = testPositions[0];
+  Game g1 = Game(cache, position);
+  Game g2 = Game(cache, "1" + position.substr(1));
+  if(g1.hash() == g2.hash()) return -1;
+
+  std::string damaged = position;
+  damaged.replace(damaged.find("0-king-140"), 10, "0-king-130");
+  Game g3 = Game(cache, damaged);
+  if(g1.hash() == g3.hash()) return -1;
+
+  // skipping both move and ability only changes the side to move
+  Game g4 = Game(cache, position);
+  g4.makeAction(MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  if(g4.hash() != g2.hash()) return -1;
+  return 0;
+}
+
+int hashtest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return hashTest1();
+  case 2:
+    return hashTest2();
+  case 3:
+    return hashTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
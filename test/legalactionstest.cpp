@@ -1,5 +1,6 @@
 #include "nichess/nichess.hpp"
 #include "nichess/util.hpp"
+#include "testutil.hpp"
 
 using namespace nichess;
 
@@ -19,7 +20,7 @@ int legalActionsTest2() {
   GameCache cache = GameCache();
   Game g = Game(cache);
 
-  g.boardFromString("0|0-king-140,1-pawn-10,empty,empty,empty,empty,empty,empty,empty,0-pawn-210,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-70,empty,0-pawn-30,empty,empty,empty,0-warrior-80,empty,empty,empty,empty,empty,empty,empty,1-pawn-100,empty,empty,empty,1-king-200,");
+  g.boardFromString(LEGAL_ACTIONS_1);
 
   std::vector<PlayerAction> usefulLegalActions = g.usefulLegalActions();
 
@@ -34,7 +35,7 @@ int legalActionsTest3() {
   GameCache cache = GameCache();
   Game g = Game(cache);
   
-  g.boardFromString("0|0-king-200,empty,empty,empty,empty,empty,empty,0-assassin-110,empty,0-pawn-300,empty,0-warrior-500,0-mage-230,0-pawn-300,empty,empty,empty,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,1-mage-230,1-warrior-500,empty,1-pawn-300,1-pawn-300,1-assassin-110,empty,empty,empty,empty,empty,empty,1-king-200,");
+  g.boardFromString(LEGAL_ACTIONS_2);
 
   std::vector<PlayerAction> usefulLegalActions = g.usefulLegalActions();
 
@@ -234,7 +235,61 @@ int legalActionsTest18() {
   }
 }
 
+/*
+ * ActionList overloads produce the same actions in the same order as the vector versions
+ */
+int legalActionsTest19() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, MIDDLEGAME);
+  Game g2 = Game(cache);
+  ActionList actions;
+  for(Game* game: {&g, &g2}) {
+    std::vector<PlayerAction> useful = game->usefulLegalActions();
+    game->usefulLegalActions(actions);
+    if((int) useful.size() != actions.size()) return -1;
+    for(int i = 0; i < actions.size(); i++) {
+      if(actions[i].moveSrcIdx != useful[i].moveSrcIdx || actions[i].moveDstIdx != useful[i].moveDstIdx ||
+          actions[i].abilitySrcIdx != useful[i].abilitySrcIdx || actions[i].abilityDstIdx != useful[i].abilityDstIdx) {
+        return -1;
+      }
+    }
+    std::vector<PlayerAction> all = game->allLegalActions();
+    game->allLegalActions(actions);
+    if((int) all.size() != actions.size()) return -1;
+    for(int i = 0; i < actions.size(); i++) {
+      if(actions[i].moveSrcIdx != all[i].moveSrcIdx || actions[i].moveDstIdx != all[i].moveDstIdx ||
+          actions[i].abilitySrcIdx != all[i].abilitySrcIdx || actions[i].abilityDstIdx != all[i].abilityDstIdx) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
 
+/*
+ * Ability effect matrix: only enemy targets are useful, the damage is the attacker's and only
+ * mages splash.
+ */
+int legalActionsTest20() {
+  for(int attacker = 0; attacker < NUM_PIECE_TYPE; attacker++) {
+    for(int target = 0; target < NUM_PIECE_TYPE; target++) {
+      AbilityEffect effect = abilityEffectTable.effects[attacker][target];
+      bool enemies = attacker != NO_PIECE && target != NO_PIECE &&
+        pieceBelongsToPlayer((PieceType) attacker, PLAYER_1) != pieceBelongsToPlayer((PieceType) target, PLAYER_1);
+      if(effect.useful != enemies) return -1;
+      if(!enemies) {
+        if(effect.splash || effect.abilityType != NO_ABILITY || effect.damage != 0) return -1;
+        continue;
+      }
+      bool mage = attacker == P1_MAGE || attacker == P2_MAGE;
+      if(effect.splash != mage) return -1;
+      if(effect.damage != abilityTypeToAbilityPoints[effect.abilityType]) return -1;
+    }
+  }
+  AbilityEffect effect = abilityEffectTable.effects[P2_ASSASSIN][P1_KING];
+  if(effect.abilityType != ASSASSIN_DAMAGE || effect.damage != ASSASSIN_ABILITY_POINTS) return -1;
+  return 0;
+}
 
 int legalactionstest(int argc, char* argv[]) {
   int defaultchoice = 1;
@@ -284,6 +339,10 @@ int legalactionstest(int argc, char* argv[]) {
     return legalActionsTest17();
   case 18:
     return legalActionsTest18();
+  case 19:
+    return legalActionsTest19();
+  case 20:
+    return legalActionsTest20();
   default:
     printf("\nInvalid test number.\n");
     return -1;
@@ -0,0 +1,323 @@
+#include "nichess/nichess.hpp"
+#include "nichess/mcts.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {WARRIOR_KILLS_KING, MAGE_SPLASH_2};
+
+static bool isLegal(Game& game, const PlayerAction& pa) {
+  return game.isActionLegal(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+}
+
+/*
+ * Immediate win is found with both selection policies
+ */
+int mctsTest1() {
+  GameCache cache = GameCache();
+  for(SelectionPolicy selectionPolicy: {UCT, PUCT}) {
+    Game g = Game(cache, testPositions[0]);
+    MctsConfig config = MctsConfig();
+    config.selectionPolicy = selectionPolicy;
+    config.maxPlayouts = 3000;
+    config.maxNodes = 1 << 16;
+    Mcts mcts = Mcts(config);
+    PlayerAction pa = mcts.search(g);
+    g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    if(!g.gameOver() || g.winner() != PLAYER_1) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Visit counts add up, game is left unchanged and every child action is legal
+ */
+int mctsTest2() {
+  GameCache cache = GameCache();
+  for(const std::string& position: testPositions) {
+    for(RolloutPolicy rolloutPolicy: {RANDOM_ROLLOUT, ABILITY_FIRST_ROLLOUT}) {
+      Game g = Game(cache, position);
+      std::string original = g.boardToString();
+      MctsConfig config = MctsConfig();
+      config.rolloutPolicy = rolloutPolicy;
+      config.maxPlayouts = 500;
+      config.maxNodes = 1 << 16;
+      config.seed = 7;
+      Mcts mcts = Mcts(config);
+      PlayerAction pa = mcts.search(g);
+      if(g.boardToString() != original) return -1;
+      if(!isLegal(g, pa)) return -1;
+      if(mcts.numPlayouts() != 500 || mcts.root().visits != 500) return -1;
+
+      const MctsNode& root = mcts.root();
+      if(root.numChildren() != g.usefulLegalActions().size()) return -1;
+      unsigned long long childVisits = 0;
+      for(uint32_t i = root.firstChild(); i < root.firstChild() + root.numChildren(); i++) {
+        const MctsNode& child = mcts.node(i);
+        childVisits += child.visits;
+        if(child.valueSum < 0 || child.valueSum.load() > child.visits.load()) return -1;
+        if(!isLegal(g, child.action())) return -1;
+      }
+      if(childVisits != 500) return -1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * PUCT uses the prior function, a tiny pool still gives a legal action, time budget stops the search
+ */
+int mctsTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  MctsConfig config = MctsConfig();
+  config.selectionPolicy = PUCT;
+  config.maxPlayouts = 200;
+  config.maxNodes = 1 << 14;
+  // all prior on the last action
+  config.priorFunction = [](const Game&, const ActionList& actions, float* priors) {
+    for(int i = 0; i < actions.size(); i++) {
+      priors[i] = i == actions.size() - 1 ? 1.0f : 0.0f;
+    }
+  };
+  Mcts mcts = Mcts(config);
+  mcts.search(g);
+  const MctsNode& root = mcts.root();
+  const MctsNode& last = mcts.node(root.firstChild() + root.numChildren() - 1);
+  if(last.prior != 1.0f || last.visits == 0) return -1;
+
+  config = MctsConfig();
+  config.maxNodes = 10;
+  Mcts tiny = Mcts(config);
+  PlayerAction pa = tiny.search(g);
+  if(!isLegal(g, pa) || tiny.numNodes() > 10) return -1;
+
+  config = MctsConfig();
+  config.maxPlayouts = 0;
+  config.maxSeconds = 0.05;
+  config.maxNodes = 1 << 16;
+  Mcts timed = Mcts(config);
+  pa = timed.search(g);
+  if(!isLegal(g, pa) || timed.numPlayouts() == 0) return -1;
+  return 0;
+}
+
+/*
+ * Several threads: the playout budget is exact, visits add up, no virtual loss is left behind,
+ * the game is unchanged and the immediate win is still found
+ */
+int mctsTest4() {
+  GameCache cache = GameCache();
+  for(const std::string& position: testPositions) {
+    Game g = Game(cache, position);
+    std::string original = g.boardToString();
+    MctsConfig config = MctsConfig();
+    config.maxPlayouts = 4000;
+    config.maxNodes = 1 << 16;
+    config.numThreads = 4;
+    Mcts mcts = Mcts(config);
+    PlayerAction pa = mcts.search(g);
+    if(g.boardToString() != original) return -1;
+    if(!isLegal(g, pa)) return -1;
+    if(mcts.numPlayouts() != 4000 || mcts.root().visits != 4000) return -1;
+    if(mcts.numNodes() > config.maxNodes) return -1;
+
+    for(uint32_t i = 0; i < mcts.numNodes(); i++) {
+      const MctsNode& n = mcts.node(i);
+      if(n.virtualLosses != 0) return -1;
+      if(!n.expanded()) continue;
+      unsigned long long childVisits = 0;
+      for(uint32_t j = n.firstChild(); j < n.firstChild() + n.numChildren(); j++) {
+        const MctsNode& child = mcts.node(j);
+        childVisits += child.visits;
+        if(child.valueSum < 0 || child.valueSum.load() > child.visits.load()) return -1;
+      }
+      // playouts that reach a node before its children are published stop there
+      if(childVisits > n.visits || childVisits == 0) return -1;
+    }
+    if(position == testPositions[0]) {
+      g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+      if(!g.gameOver() || g.winner() != PLAYER_1) return -1;
+    }
+  }
+
+  Game g = Game(cache);
+  MctsConfig config = MctsConfig();
+  config.maxPlayouts = 0;
+  config.maxSeconds = 0.05;
+  config.maxNodes = 1 << 16;
+  config.numThreads = 3;
+  Mcts timed = Mcts(config);
+  PlayerAction pa = timed.search(g);
+  if(!isLegal(g, pa) || timed.numPlayouts() == 0) return -1;
+  return 0;
+}
+
+/*
+ * Advancing keeps the subtree of the played action and frees the rest, the next search
+ * continues from it and reuses the freed nodes
+ */
+int mctsTest5() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  MctsConfig config = MctsConfig();
+  config.maxPlayouts = 2000;
+  config.maxNodes = 1 << 14;
+  Mcts mcts = Mcts(config);
+  PlayerAction pa = mcts.search(g);
+  uint32_t nodesBefore = mcts.numNodes();
+  uint32_t kept = 0;
+  const MctsNode& root = mcts.root();
+  for(uint32_t i = root.firstChild(); i < root.firstChild() + root.numChildren(); i++) {
+    const MctsNode& child = mcts.node(i);
+    if(child.action().moveSrcIdx == pa.moveSrcIdx && child.action().moveDstIdx == pa.moveDstIdx &&
+        child.action().abilitySrcIdx == pa.abilitySrcIdx && child.action().abilityDstIdx == pa.abilityDstIdx) {
+      kept = i;
+    }
+  }
+  uint32_t keptVisits = mcts.node(kept).visits;
+  uint32_t keptChildren = mcts.node(kept).numChildren();
+  if(keptVisits == 0 || keptChildren == 0) return -1;
+
+  g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  if(!mcts.advance(pa, g)) return -1;
+  if(mcts.root().visits != keptVisits || mcts.root().numChildren() != keptChildren) return -1;
+  if(mcts.numNodes() >= nodesBefore) return -1;
+  for(uint32_t i = mcts.root().firstChild(); i < mcts.root().firstChild() + mcts.root().numChildren(); i++) {
+    if(!isLegal(g, mcts.node(i).action())) return -1;
+  }
+
+  // more nodes are expanded than the pool holds, so freed nodes are reused
+  unsigned long long expandedNodes = nodesBefore;
+  for(int move = 0; move < 6 && !g.gameOver(); move++) {
+    uint32_t nodesAfterAdvance = mcts.numNodes();
+    pa = mcts.search(g);
+    if(!isLegal(g, pa) || mcts.numNodes() > config.maxNodes) return -1;
+    expandedNodes += mcts.numNodes() - nodesAfterAdvance;
+    g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    mcts.advance(pa, g);
+  }
+  if(expandedNodes <= config.maxNodes) return -1;
+
+  // an action that isn't in the tree clears it, and so does searching another position
+  PlayerAction skip = PlayerAction(MOVE_SKIP, MOVE_SKIP, 0, 0);
+  if(mcts.advance(skip, g) || mcts.numNodes() != 1 || mcts.root().visits != 0) return -1;
+  mcts.search(g);
+  Game other = Game(cache);
+  mcts.search(other);
+  if(mcts.root().visits != config.maxPlayouts) return -1;
+  return 0;
+}
+
+/*
+ * After advance, the kept tree is only reused for the position advance was given
+ */
+int mctsTest6() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  MctsConfig config = MctsConfig();
+  config.maxPlayouts = 500;
+  config.maxNodes = 1 << 14;
+  Mcts mcts = Mcts(config);
+  PlayerAction pa = mcts.search(g);
+  Game played = g;
+  played.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  if(!mcts.advance(pa, played)) return -1;
+  uint32_t keptVisits = mcts.root().visits;
+  if(keptVisits == 0) return -1;
+  mcts.search(played);
+  if(mcts.root().visits != keptVisits + config.maxPlayouts) return -1;
+
+  // searching a position where pa wasn't played starts a new tree
+  PlayerAction next = mcts.search(played);
+  played.makeAction(next.moveSrcIdx, next.moveDstIdx, next.abilitySrcIdx, next.abilityDstIdx);
+  if(!mcts.advance(next, played)) return -1;
+  mcts.search(g);
+  if(mcts.root().visits != config.maxPlayouts) return -1;
+  const MctsNode& root = mcts.root();
+  for(uint32_t i = root.firstChild(); i < root.firstChild() + root.numChildren(); i++) {
+    if(!isLegal(g, mcts.node(i).action())) return -1;
+  }
+  return 0;
+}
+
+/*
+ * MCTS playouts and tree reuse don't allocate once the search object exists
+ */
+int mctsTest7() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  MctsConfig config = MctsConfig();
+  config.maxPlayouts = 300;
+  config.maxNodes = 1 << 16;
+  Mcts mcts = Mcts(config);
+  unsigned long long allocationsBefore = numAllocations;
+  PlayerAction pa = mcts.search(g);
+  g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  bool advanced = mcts.advance(pa, g);
+  mcts.search(g);
+  unsigned long long allocationsAfter = numAllocations;
+  if(allocationsBefore != allocationsAfter || !advanced || mcts.numPlayouts() != 300) return -1;
+  return 0;
+}
+
+/*
+ * A config without budget is rejected, a pool of 0 nodes still holds the root
+ */
+int mctsTest8() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  MctsConfig config = MctsConfig();
+  config.maxPlayouts = 0;
+  config.maxSeconds = 0;
+  try {
+    Mcts mcts = Mcts(config);
+    return -1;
+  } catch(const char*) { }
+
+  config.maxPlayouts = 20;
+  config.maxNodes = 0;
+  Mcts mcts = Mcts(config);
+  PlayerAction pa = mcts.search(g);
+  if(!isLegal(g, pa) || mcts.numPlayouts() != 20) return -1;
+  return 0;
+}
+
+int mctstest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return mctsTest1();
+  case 2:
+    return mctsTest2();
+  case 3:
+    return mctsTest3();
+  case 4:
+    return mctsTest4();
+  case 5:
+    return mctsTest5();
+  case 6:
+    return mctsTest6();
+  case 7:
+    return mctsTest7();
+  case 8:
+    return mctsTest8();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
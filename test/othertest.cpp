@@ -1,6 +1,9 @@
 #include "nichess/nichess.hpp"
 #include "nichess/util.hpp"
 
+#include <cstring>
+#include <utility>
+
 using namespace nichess;
 
 int copyTest1() {
@@ -37,6 +40,53 @@ int copyTest2() {
   }
 }
 
+/*
+ * Copy of a position with dead pieces, which keep their slot but are not on the board.
+ */
+int copyTest3() {
+  GameCache cache = GameCache();
+  Game g1 = Game(cache);
+  g1.makeAction(7, 28, ABILITY_SKIP, ABILITY_SKIP);
+  g1.makeAction(56, 35, 35, 28);
+  Game g2 = Game(g1);
+
+  if(g1.boardToString() != g2.boardToString()) return -1;
+  if(g2.playerPiece(PLAYER_1, ASSASSIN_PIECE_INDEX)->healthPoints > 0) return -1;
+  if(perft(g1, 2) != perft(g2, 2)) return -1;
+  return 0;
+}
+
+/*
+ * Copy assignment and memcpy clones of a game in progress are independent of the original
+ */
+int copyTest4() {
+  GameCache cache = GameCache();
+  Game g1 = Game(cache);
+  g1.makeAction(7, 28, ABILITY_SKIP, ABILITY_SKIP);
+  g1.makeAction(56, 35, 35, 28);
+  Game g2 = Game(cache);
+  g2 = g1;
+  alignas(Game) unsigned char buffer[sizeof(Game)];
+  std::memcpy(buffer, &g1, sizeof(Game));
+  Game* g3 = reinterpret_cast<Game*>(buffer);
+
+  for(Game* g: {&g2, g3}) {
+    if(g->boardToString() != g1.boardToString() || g->hash() != g1.hash()) return -1;
+    if(g->accumulators() != g1.accumulators()) return -1;
+    if(perft(*g, 2) != perft(g1, 2)) return -1;
+  }
+  std::string before = g1.boardToString();
+  PlayerAction pa = g2.usefulLegalActions()[0];
+  g2.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  g3->makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  if(g1.boardToString() != before) return -1;
+  if(g2.boardToString() != g3->boardToString() || g2.boardToString() == before) return -1;
+
+  Game g4 = std::move(g2);
+  if(g4.boardToString() != g3->boardToString() || g4.hash() != g4.computeHash()) return -1;
+  return 0;
+}
+
 int othertest(int argc, char* argv[]) {
   int defaultchoice = 1;
   int choice = defaultchoice;
@@ -53,6 +103,10 @@ int othertest(int argc, char* argv[]) {
     return copyTest1();
   case 2:
     return copyTest2();
+  case 3:
+    return copyTest3();
+  case 4:
+    return copyTest4();
   default:
     printf("\nInvalid test number.\n");
     return -1;
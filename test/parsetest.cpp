@@ -0,0 +1,129 @@
+#include "nichess/nichess.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME};
+
+/*
+ * Parsing and writing round trip, also when an existing game is reused and without the
+ * trailing comma
+ */
+int parseTest1() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  std::string opening = g.boardToString();
+  for(const std::string& position: testPositions) {
+    if(g.parseBoard(position) != PARSE_OK || g.boardToString() != position) return -1;
+    if(g.hash() != g.computeHash() || g.accumulators() != g.computeAccumulators()) return -1;
+    Game constructed = Game(cache, position);
+    if(constructed.hash() != g.hash()) return -1;
+  }
+  if(g.parseBoard(std::string_view(opening).substr(0, opening.size() - 1)) != PARSE_OK) return -1;
+  if(g.boardToString() != opening || g.hash() != Game(cache).hash()) return -1;
+  return 0;
+}
+
+/*
+ * Malformed boards give the matching error and leave the game unchanged
+ */
+int parseTest2() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[1]);
+  std::string original = g.boardToString();
+  std::string board = testPositions[0];
+  std::string tail = board.substr(2);
+  std::vector<std::pair<std::string, ParseError>> malformed = {
+    {"", PARSE_BAD_PLAYER},
+    {"2|" + tail, PARSE_BAD_PLAYER},
+    {"0," + tail, PARSE_BAD_PLAYER},
+    {"0|0-queen-100," + tail.substr(tail.find(',') + 1), PARSE_BAD_TOKEN},
+    {"0|0king140," + tail.substr(tail.find(',') + 1), PARSE_BAD_TOKEN},
+    {"0|emptyy," + tail.substr(tail.find(',') + 1), PARSE_BAD_TOKEN},
+    {"0|0-king-," + tail.substr(tail.find(',') + 1), PARSE_BAD_HEALTH_POINTS},
+    {"0|0-king-0," + tail.substr(tail.find(',') + 1), PARSE_BAD_HEALTH_POINTS},
+    {"0|0-king-12x," + tail.substr(tail.find(',') + 1), PARSE_BAD_HEALTH_POINTS},
+    {"0|0-king-99999999999," + tail.substr(tail.find(',') + 1), PARSE_BAD_HEALTH_POINTS},
+    {"0|1-king-100," + tail.substr(tail.find(',') + 1), PARSE_TOO_MANY_PIECES},
+    {"0|0-pawn-1,0-pawn-1,0-pawn-1," + tail.substr(tail.find(',') + 1), PARSE_TOO_MANY_PIECES},
+    {board + "empty,", PARSE_BAD_SQUARE_COUNT},
+    {board.substr(0, board.size() - 12), PARSE_BAD_SQUARE_COUNT},
+  };
+  for(const auto& [encodedBoard, expected]: malformed) {
+    if(g.parseBoard(encodedBoard) != expected) return -1;
+    if(g.boardToString() != original) return -1;
+  }
+  // the string constructor still throws
+  try {
+    Game(cache, "2|" + tail);
+    return -1;
+  } catch(const char* message) {
+    if(std::string(message) != parseErrorToString(PARSE_BAD_PLAYER)) return -1;
+  }
+  return 0;
+}
+
+/*
+ * appendBoard keeps what's already in the buffer
+ */
+int parseTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[0]);
+  std::string buffer = "board: ";
+  g.appendBoard(buffer);
+  buffer += "\n";
+  if(buffer != "board: " + testPositions[0] + "\n") return -1;
+  if((int) g.boardToString().size() > MAX_BOARD_STRING_LENGTH) return -1;
+  return 0;
+}
+
+/*
+ * Text boards are parsed and written into a reserved buffer without allocating
+ */
+int parseTest4() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  std::string encodedBoard = g.boardToString();
+  std::string buffer;
+  buffer.reserve(MAX_BOARD_STRING_LENGTH);
+  Game parsed = Game(cache);
+  parsed.makeAction(9, 17, ABILITY_SKIP, ABILITY_SKIP);
+  unsigned long long allocationsBefore = numAllocations;
+  ParseError error = parsed.parseBoard(encodedBoard);
+  parsed.appendBoard(buffer);
+  unsigned long long allocationsAfter = numAllocations;
+  if(allocationsBefore != allocationsAfter || error != PARSE_OK || buffer != encodedBoard) return -1;
+  return 0;
+}
+
+int parsetest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return parseTest1();
+  case 2:
+    return parseTest2();
+  case 3:
+    return parseTest3();
+  case 4:
+    return parseTest4();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,102 @@
+#include "nichess/nichess.hpp"
+#include "nichess/perft.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME};
+
+/*
+ * Hashed perft gives the same counts as perft and leaves the game unchanged
+ */
+int perftTest1() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  std::string original = g.boardToString();
+  unsigned long long expected[] = {42, 1775, 78765, 3771628};
+  for(int depth = 1; depth <= 4; depth++) {
+    if(perftHashed(g, depth, 1 << 20).nodes != expected[depth-1]) return -1;
+  }
+  if(g.boardToString() != original || g.hash() != g.computeHash()) return -1;
+
+  for(const std::string& position: testPositions) {
+    Game g2 = Game(cache, position);
+    for(int depth = 1; depth <= 3; depth++) {
+      if(perftHashed(g2, depth, 1 << 16).nodes != perft(g2, depth)) return -1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Transpositions are found, and a missing or tiny table still gives exact counts
+ */
+int perftTest2() {
+  GameCache cache = GameCache();
+  // kings and one pawn each, transpositions start at depth 5
+  Game endgame = Game(cache, "0|0-king-200,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-king-200,");
+  PerftResult result = perftHashed(endgame, 5, 1 << 20);
+  if(result.nodes != perft(endgame, 5)) return -1;
+  if(result.hits == 0 || result.hitRate() <= 0 || result.hitRate() > 1) return -1;
+
+  Game g = Game(cache);
+
+  PerftResult noTable = perftHashed(g, 3, 0);
+  if(noTable.nodes != 78765 || noTable.hits != 0) return -1;
+  PerftResult tinyTable = perftHashed(g, 3, 100);
+  if(tinyTable.nodes != 78765) return -1;
+  return 0;
+}
+
+/*
+ * Parallel perft matches serial perft for any number of threads and split depth
+ */
+int perftTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  std::string original = g.boardToString();
+  if(perftParallel(g, 4, 4) != 3771628) return -1;
+  if(perftParallel(g, 3, 1) != 78765) return -1;
+  if(perftParallel(g, 1, 3) != 42) return -1;
+  if(g.boardToString() != original) return -1;
+
+  for(const std::string& position: testPositions) {
+    Game g2 = Game(cache, position);
+    unsigned long long expected = perft(g2, 3);
+    for(int numThreads: {1, 2, 3, 8}) {
+      for(int minSplitDepth: {2, 3}) {
+        if(perftParallel(g2, 3, numThreads, minSplitDepth) != expected) return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+int perfttest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return perftTest1();
+  case 2:
+    return perftTest2();
+  case 3:
+    return perftTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
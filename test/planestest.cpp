@@ -0,0 +1,151 @@
+#include "nichess/nichess.hpp"
+#include "nichess/batch.hpp"
+#include "nichess/planes.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {MIDDLEGAME};
+
+/*
+ * Same position with the rows mirrored, the players swapped and player 1 to move
+ */
+static std::string mirrorPosition(Game& game) {
+  std::string retval = game.currentPlayer == PLAYER_1 ? "1|" : "0|";
+  for(int i = 0; i < NUM_SQUARES; i++) {
+    int mirrored = (NUM_ROWS - 1 - i / NUM_COLUMNS) * NUM_COLUMNS + i % NUM_COLUMNS;
+    Piece piece = game.getPieceBySquareIndex(mirrored);
+    if(piece.type == NO_PIECE) {
+      retval += "empty,";
+      continue;
+    }
+    bool player1 = pieceBelongsToPlayer(piece.type, PLAYER_1);
+    retval += player1 ? "1-" : "0-";
+    switch(piece.type) {
+      case P1_KING: case P2_KING: retval += "king-"; break;
+      case P1_MAGE: case P2_MAGE: retval += "mage-"; break;
+      case P1_WARRIOR: case P2_WARRIOR: retval += "warrior-"; break;
+      case P1_ASSASSIN: case P2_ASSASSIN: retval += "assassin-"; break;
+      default: retval += "pawn-"; break;
+    }
+    retval += std::to_string(piece.healthPoints) + ",";
+  }
+  return retval;
+}
+
+/*
+ * Starting position planes
+ */
+int planesTest1() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  std::vector<float> planes(INPUT_PLANES_SIZE, -1.0f);
+  encodePlanes(g, planes.data());
+  float pieceSum = 0;
+  for(int i = 0; i < NUM_PIECE_PLANES * NUM_SQUARES; i++) {
+    pieceSum += planes[i];
+  }
+  if(pieceSum != NUM_PLAYERS * NUM_STARTING_PIECES) return -1;
+  if(planes[P1_KING * NUM_SQUARES + 0] != 1.0f || planes[P2_KING * NUM_SQUARES + 63] != 1.0f) return -1;
+  if(planes[P1_PAWN * NUM_SQUARES + 8] != 1.0f || planes[P1_KING * NUM_SQUARES + 8] != 0.0f) return -1;
+  if(planes[HEALTH_POINTS_PLANE * NUM_SQUARES + 0] != (float) KING_STARTING_HEALTH_POINTS / HEALTH_POINTS_SCALE) return -1;
+  if(planes[HEALTH_POINTS_PLANE * NUM_SQUARES + 30] != 0.0f) return -1;
+  for(int i = 0; i < NUM_SQUARES; i++) {
+    if(planes[PLAYER_PLANE * NUM_SQUARES + i] != 0.0f) return -1;
+  }
+
+  std::vector<int8_t> quantized(INPUT_PLANES_SIZE);
+  encodePlanes(g, quantized.data());
+  for(int i = 0; i < INPUT_PLANES_SIZE; i++) {
+    if(quantized[i] != (int8_t) std::lround(planes[i] * INT8_PLANE_ONE)) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Planes from the side to move are the planes of the mirrored position, apart from the player plane
+ */
+int planesTest2() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[0]);
+  Game mirrored = Game(cache, mirrorPosition(g));
+  std::vector<float> oriented(INPUT_PLANES_SIZE);
+  std::vector<float> expected(INPUT_PLANES_SIZE);
+  encodePlanes(g, oriented.data(), true);
+  encodePlanes(mirrored, expected.data(), false);
+  for(int i = 0; i < PLAYER_PLANE * NUM_SQUARES; i++) {
+    if(oriented[i] != expected[i]) return -1;
+  }
+  for(int i = PLAYER_PLANE * NUM_SQUARES; i < INPUT_PLANES_SIZE; i++) {
+    if(oriented[i] != 1.0f || expected[i] != 0.0f) return -1;
+  }
+  // nothing changes when player 1 is to move
+  std::vector<float> absolute(INPUT_PLANES_SIZE);
+  encodePlanes(mirrored, oriented.data(), true);
+  encodePlanes(mirrored, absolute.data(), false);
+  if(oriented != absolute) return -1;
+  return 0;
+}
+
+/*
+ * Batched encoders match the single game encoder
+ */
+int planesTest3() {
+  GameCache cache = GameCache();
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0])};
+  games[0].makeAction(9, 17, ABILITY_SKIP, ABILITY_SKIP);
+  GameBatch batch = GameBatch(cache, 2);
+  batch.store(0, games[0]);
+  batch.store(1, games[1]);
+  for(bool sideToMove: {false, true}) {
+    std::vector<float> single(INPUT_PLANES_SIZE);
+    std::vector<float> batched(2 * INPUT_PLANES_SIZE);
+    std::vector<float> fromBatch(2 * INPUT_PLANES_SIZE);
+    std::vector<int8_t> single8(INPUT_PLANES_SIZE);
+    std::vector<int8_t> fromBatch8(2 * INPUT_PLANES_SIZE);
+    encodePlanes(games.data(), 2, batched.data(), sideToMove);
+    batch.encodePlanes(fromBatch.data(), sideToMove);
+    batch.encodePlanes(fromBatch8.data(), sideToMove);
+    if(batched != fromBatch) return -1;
+    for(int g = 0; g < 2; g++) {
+      encodePlanes(games[g], single.data(), sideToMove);
+      encodePlanes(games[g], single8.data(), sideToMove);
+      for(int i = 0; i < INPUT_PLANES_SIZE; i++) {
+        if(batched[g * INPUT_PLANES_SIZE + i] != single[i]) return -1;
+        if(fromBatch8[g * INPUT_PLANES_SIZE + i] != single8[i]) return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+int planestest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return planesTest1();
+  case 2:
+    return planesTest2();
+  case 3:
+    return planesTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
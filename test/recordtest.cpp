@@ -0,0 +1,130 @@
+#include "nichess/nichess.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {LEGAL_ACTIONS_1, MIDDLEGAME};
+
+static bool samePosition(Game& g1, Game& g2) {
+  return g1.boardToString() == g2.boardToString() && g1.hash() == g2.hash() &&
+    g1.accumulators() == g2.accumulators() && g1.moveNumber == g2.moveNumber;
+}
+
+/*
+ * Every position of games with kills survives an encode/decode round trip
+ */
+int recordTest1() {
+  static_assert(sizeof(PositionRecord) == POSITION_RECORD_SIZE, "record must not be padded");
+  GameCache cache = GameCache();
+  std::vector<Game> games = {Game(cache), Game(cache, testPositions[0]), Game(cache, testPositions[1])};
+  Game decoded = Game(cache);
+  PositionRecord record;
+  auto check = [&](Game& g, const std::vector<PlayerAction>&) {
+    g.encode(record);
+    if(!decoded.decode(record) || !samePosition(g, decoded)) return false;
+    g.moveNumber++;
+    return true;
+  };
+  for(Game& g: games) {
+    if(!playSeededGame(g, 60, check)) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Layout of the starting position
+ */
+int recordTest2() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  g.moveNumber = 258;
+  PositionRecord record;
+  g.encode(record);
+  if(record.bytes[0] != PLAYER_1 || record.bytes[1] != 0) return -1;
+  if(record.bytes[2] != 2 || record.bytes[3] != 1) return -1;
+  // player 2 king: square 63, 200 health points
+  int offset = 4 + 2 * (NUM_STARTING_PIECES + KING_PIECE_INDEX);
+  int word = record.bytes[offset] | (record.bytes[offset + 1] << 8);
+  if(word != (63 | (KING_STARTING_HEALTH_POINTS << 6))) return -1;
+  return 0;
+}
+
+/*
+ * Malformed records are rejected and leave the game unchanged
+ */
+int recordTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[1]);
+  std::string original = g.boardToString();
+  PositionRecord valid;
+  Game(cache).encode(valid);
+
+  PositionRecord record = valid;
+  record.bytes[0] = 2;
+  if(g.decode(record)) return -1;
+  record = valid;
+  record.bytes[1] = 1;
+  if(g.decode(record)) return -1;
+  // player 2 king on the square of player 1 king
+  record = valid;
+  int offset = 4 + 2 * (NUM_STARTING_PIECES + KING_PIECE_INDEX);
+  record.bytes[offset] = (uint8_t) ((record.bytes[offset] & 0xC0) | 0);
+  if(g.decode(record)) return -1;
+  if(g.boardToString() != original) return -1;
+
+  // a dead piece may share its square with a living one
+  record = valid;
+  record.bytes[offset] = 0;
+  record.bytes[offset + 1] = 0;
+  if(!g.decode(record) || g.gameOver() == false || g.winner() != PLAYER_1) return -1;
+  return 0;
+}
+
+/*
+ * Binary position records are written and read without allocating
+ */
+int recordTest4() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  Game decoded = Game(cache);
+  PositionRecord record;
+  unsigned long long allocationsBefore = numAllocations;
+  g.makeAction(9, 17, ABILITY_SKIP, ABILITY_SKIP);
+  g.encode(record);
+  bool ok = decoded.decode(record);
+  unsigned long long allocationsAfter = numAllocations;
+  if(allocationsBefore != allocationsAfter || !ok || decoded.hash() != g.hash()) return -1;
+  return 0;
+}
+
+int recordtest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return recordTest1();
+  case 2:
+    return recordTest2();
+  case 3:
+    return recordTest3();
+  case 4:
+    return recordTest4();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,136 @@
+#include "nichess/nichess.hpp"
+#include "nichess/search.hpp"
+#include "nichess/evaluate.hpp"
+#include "nichess/util.hpp"
+#include "testutil.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace nichess;
+
+static const std::string testPositions[] = {WARRIOR_KILLS_KING, LEGAL_ACTIONS_1, MAGE_SPLASH_2};
+
+/*
+ * Plain negamax without pruning
+ */
+static int minimax(Game& game, int depth, int ply) {
+  if(game.gameOver()) {
+    return game.winner() == game.currentPlayer ? WIN_SCORE - ply : -(WIN_SCORE - ply);
+  }
+  if(depth == 0) return evaluate(game);
+  int best = -WIN_SCORE - 1;
+  for(PlayerAction pa: game.usefulLegalActions()) {
+    UndoInfo ui = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    best = std::max(best, -minimax(game, depth - 1, ply + 1));
+    game.undoAction(ui);
+  }
+  return best;
+}
+
+/*
+ * Immediate win is found and reported with the win score
+ */
+int searchTest1() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, testPositions[0]);
+  Search search = Search();
+  SearchLimits limits = SearchLimits();
+  limits.maxDepth = 4;
+  SearchResult result = search.search(g, limits);
+  if(result.score != WIN_SCORE - 1) return -1;
+  if(result.pv.size() != 1) return -1;
+  PlayerAction pa = result.bestAction;
+  g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  if(!g.gameOver() || g.winner() != PLAYER_1) return -1;
+
+  // nothing to search when the game is over
+  SearchResult result2 = search.search(g, limits);
+  if(result2.depth != 0 || !result2.pv.empty()) return -1;
+  return 0;
+}
+
+/*
+ * Alpha-beta with PVS and aspiration windows gives the same score as plain negamax
+ */
+int searchTest2() {
+  GameCache cache = GameCache();
+  Search search = Search();
+  for(const std::string& position: testPositions) {
+    Game g = Game(cache, position);
+    for(int depth = 1; depth <= 3; depth++) {
+      SearchLimits limits = SearchLimits();
+      limits.maxDepth = depth;
+      SearchResult result = search.search(g, limits);
+      int expected = minimax(g, depth, 0);
+      if(result.score != expected) return -1;
+      // forced wins end the iterations early
+      if(result.depth != depth && result.score < WIN_SCORE - MAX_SEARCH_PLY) return -1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * PV is legal and leaves the game unchanged, node and time budgets are respected
+ */
+int searchTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  std::string original = g.boardToString();
+  Search search = Search();
+  SearchLimits limits = SearchLimits();
+  limits.maxDepth = 3;
+  SearchResult result = search.search(g, limits);
+  if(g.boardToString() != original) return -1;
+  if(result.depth != 3 || result.pv.empty()) return -1;
+  Game replay = Game(g);
+  for(const PlayerAction& pa: result.pv) {
+    if(!replay.isActionLegal(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx)) return -1;
+    replay.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  }
+
+  limits = SearchLimits();
+  limits.maxNodes = 5000;
+  result = search.search(g, limits);
+  if(result.depth < 1 || result.nodes > limits.maxNodes + MAX_NUM_ACTIONS) return -1;
+  if(!g.isActionLegal(result.bestAction.moveSrcIdx, result.bestAction.moveDstIdx,
+        result.bestAction.abilitySrcIdx, result.bestAction.abilityDstIdx)) {
+    return -1;
+  }
+  if(g.boardToString() != original) return -1;
+
+  limits = SearchLimits();
+  limits.maxSeconds = 0.05;
+  result = search.search(g, limits);
+  if(result.depth < 1 || result.depth >= MAX_SEARCH_PLY) return -1;
+  if(g.boardToString() != original) return -1;
+  return 0;
+}
+
+int searchtest(int argc, char* argv[]) {
+  int defaultchoice = 1;
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+
+  switch(choice) {
+  case 1:
+    return searchTest1();
+  case 2:
+    return searchTest2();
+  case 3:
+    return searchTest3();
+  default:
+    printf("\nInvalid test number.\n");
+    return -1;
+  }
+
+  return -1;
+}
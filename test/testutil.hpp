@@ -0,0 +1,60 @@
+#pragma once
+
+#include "nichess/nichess.hpp"
+#include "benchpositions.hpp"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Positions and deterministic games shared by the tests, on top of the bench positions.
+ */
+
+// Heap allocations made so far by the whole test runner, see alloccounter.cpp. Atomic because
+// some tests allocate from several threads.
+extern std::atomic<unsigned long long> numAllocations;
+
+// player 2 to move, pieces of both players mixed in the middle of the board
+inline const std::string MIDDLEGAME = "1|empty,empty,empty,empty,empty,empty,empty,empty,empty,0-pawn-300,empty,0-king-80,empty,empty,empty,empty,empty,empty,0-mage-150,1-warrior-400,0-pawn-60,empty,empty,empty,empty,empty,1-mage-70,0-warrior-200,1-pawn-90,empty,empty,empty,empty,empty,empty,1-king-200,0-assassin-110,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,";
+
+// player 1 warrior can kill player 2 king
+inline const std::string WARRIOR_KILLS_KING = "0|0-king-200,empty,empty,empty,empty,empty,empty,empty,empty,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,0-warrior-500,empty,empty,empty,empty,empty,empty,empty,empty,1-king-50,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,empty,empty,empty,empty,empty,empty,1-mage-230,empty,";
+
+// every piece alive, close to the starting position
+inline const std::string FULL_ARMIES = "0|0-king-200,0-assassin-110,empty,empty,empty,empty,empty,empty,0-pawn-300,0-pawn-300,empty,0-warrior-500,0-mage-230,0-pawn-300,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-300,1-mage-230,1-warrior-500,empty,1-pawn-300,1-pawn-300,1-assassin-110,empty,empty,empty,empty,empty,empty,1-king-200,";
+
+/*
+ * Action for ply of a deterministic game: spread over the actions by a large prime, but an
+ * action with an ability on two plies out of three, to reach positions with dead pieces.
+ * Games with a different seed take different actions.
+ */
+inline nichess::PlayerAction seededAction(const std::vector<nichess::PlayerAction>& actions, int ply, int seed = 0) {
+  if((seed + ply) % 3 != 0) {
+    for(const nichess::PlayerAction& candidate: actions) {
+      if(candidate.abilitySrcIdx != nichess::ABILITY_SKIP) return candidate;
+    }
+  }
+  return actions[(seed * 31 + ply * 7919) % actions.size()];
+}
+
+typedef std::function<bool(nichess::Game& game, const std::vector<nichess::PlayerAction>& actions)> PositionCheck;
+
+/*
+ * Plays seededAction for at most plies plies, or until there are no actions. check sees every
+ * position of the game with its useful legal actions, the last one included, and returns
+ * false to fail the game. The UndoInfo of every action is appended to undoInfos if given.
+ */
+inline bool playSeededGame(nichess::Game& game, int plies, const PositionCheck& check,
+    std::vector<nichess::UndoInfo>* undoInfos = nullptr) {
+  for(int ply = 0; ply <= plies; ply++) {
+    std::vector<nichess::PlayerAction> actions = game.usefulLegalActions();
+    if(!check(game, actions)) return false;
+    if(actions.empty() || ply == plies) break;
+    nichess::PlayerAction pa = seededAction(actions, ply);
+    nichess::UndoInfo undoInfo = game.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    if(undoInfos != nullptr) undoInfos->push_back(undoInfo);
+  }
+  return true;
+}
@@ -1,5 +1,7 @@
 #include "nichess/nichess.hpp"
+#include "nichess/mcts.hpp"
 #include "nichess/util.hpp"
+#include "testutil.hpp"
 
 using namespace nichess;
 
@@ -41,6 +43,168 @@ int undoActionTest2() {
   }
 }
 
+/*
+ * makeAction and undoAction, including kills and revivals, don't allocate.
+ */
+int undoActionTest3() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, LEGAL_ACTIONS_1);
+
+  std::vector<PlayerAction> legalActions = g.usefulLegalActions();
+  std::string b1 = g.boardToString();
+  unsigned long long allocationsBefore = numAllocations;
+  for(PlayerAction pa: legalActions) {
+    UndoInfo ui = g.makeAction(pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+    g.undoAction(ui);
+  }
+  unsigned long long allocationsAfter = numAllocations;
+  std::string b2 = g.boardToString();
+
+  if(b1 == b2 && allocationsBefore == allocationsAfter) {
+    return 0;
+  } else {
+    return -1;
+  }
+}
+
+/*
+ * Action generation into an ActionList doesn't allocate, and perft only allocates its
+ * action stack once, independent of the number of nodes.
+ */
+int undoActionTest4() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  ActionList* actions = new ActionList();
+  unsigned long long allocationsBefore = numAllocations;
+  g.usefulLegalActions(*actions);
+  g.allLegalActions(*actions);
+  unsigned long long allocationsAfter = numAllocations;
+  delete actions;
+  if(allocationsBefore != allocationsAfter) return -1;
+
+  allocationsBefore = numAllocations;
+  unsigned long long nodes = perft(g, 3);
+  allocationsAfter = numAllocations;
+  if(nodes != 78765 || allocationsAfter - allocationsBefore > 1) return -1;
+  return 0;
+}
+
+/*
+ * GameHistory walks a whole game back, UndoInfos also revert a copy of the game
+ */
+int undoActionTest5() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  GameHistory history;
+  std::vector<std::string> boards;
+  std::vector<UndoInfo> undoInfos;
+  for(int ply = 0; ply < 80; ply++) {
+    std::vector<PlayerAction> useful = g.usefulLegalActions();
+    if(useful.empty()) break;
+    PlayerAction pa = seededAction(useful, ply);
+    boards.push_back(g.boardToString());
+    undoInfos.push_back(history.makeAction(g, pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx));
+  }
+  if(history.length() != (int) boards.size()) return -1;
+
+  Game copy = g;
+  for(int i = (int) boards.size() - 1; i >= 0; i--) {
+    copy.undoAction(undoInfos[i]);
+    if(copy.boardToString() != boards[i] || copy.hash() != copy.computeHash()) return -1;
+  }
+  if(history.length() != (int) boards.size()) return -1;
+  unsigned long long allocationsBefore = numAllocations;
+  int numUndone = 0;
+  while(history.undo(g)) {
+    numUndone++;
+  }
+  unsigned long long allocationsAfter = numAllocations;
+  if(allocationsBefore != allocationsAfter || numUndone != (int) boards.size()) return -1;
+  if(g.boardToString() != boards[0] || g.hash() != Game(cache).hash()) return -1;
+  return 0;
+}
+
+/*
+ * GameHistory keeps the last UNDO_HISTORY_LENGTH actions, the history isn't part of the Game
+ */
+int undoActionTest6() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  GameHistory history;
+  for(int i = 0; i < UNDO_HISTORY_LENGTH + 50; i++) {
+    history.makeAction(g, i % 2, 1 - i % 2, ABILITY_SKIP, ABILITY_SKIP);
+    history.makeAction(g, MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  }
+  if(history.length() != UNDO_HISTORY_LENGTH) return -1;
+  int numUndone = 0;
+  while(history.undo(g)) {
+    numUndone++;
+  }
+  if(numUndone != UNDO_HISTORY_LENGTH || g.moveNumber != 2 * (UNDO_HISTORY_LENGTH + 50) - UNDO_HISTORY_LENGTH) return -1;
+  if(g.hash() != g.computeHash()) return -1;
+
+  history.makeAction(g, MOVE_SKIP, MOVE_SKIP, ABILITY_SKIP, ABILITY_SKIP);
+  history.clear();
+  if(history.length() != 0 || history.undo(g)) return -1;
+  if(sizeof(UndoInfo) > 8 || sizeof(Game) > 512) return -1;
+  return 0;
+}
+
+/*
+ * Mage splash: the attacked piece and the enemy pieces touching it are damaged, own pieces are
+ * not, and the undo record keeps the damaged and the killed slots as bitmasks.
+ */
+int undoActionTest7() {
+  GameCache cache = GameCache();
+  Game g = Game(cache, "0|0-king-200,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,0-mage-230,empty,empty,empty,empty,empty,empty,empty,empty,1-pawn-50,1-pawn-300,empty,empty,empty,empty,empty,empty,0-pawn-300,1-warrior-70,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,empty,1-king-200,");
+  std::string before = g.boardToString();
+  uint64_t hashBefore = g.hash();
+  Accumulators accumulatorsBefore = g.accumulators();
+  int slots[NUM_SQUARES];
+  for(int i = 0; i < NUM_STARTING_PIECES; i++) {
+    const Piece* piece = g.playerPiece(PLAYER_2, i);
+    if(piece->healthPoints > 0) slots[piece->squareIndex] = i;
+  }
+
+  UndoInfo undoInfo = g.makeAction(MOVE_SKIP, MOVE_SKIP, 18, 27);
+  if(undoInfo.abilityType != MAGE_DAMAGE) return -1;
+  if(undoInfo.affectedSlots != ((1 << slots[27]) | (1 << slots[28]) | (1 << slots[36]))) return -1;
+  if(undoInfo.killedSlots != ((1 << slots[27]) | (1 << slots[36]))) return -1;
+  if(!g.isSquareEmpty(27) || !g.isSquareEmpty(36) || g.pieceAt(28)->healthPoints != 300 - MAGE_ABILITY_POINTS) return -1;
+  if(g.pieceAt(35)->healthPoints != 300) return -1;
+  if(g.hash() != g.computeHash() || g.accumulators() != g.computeAccumulators()) return -1;
+
+  g.undoAction(undoInfo);
+  if(g.boardToString() != before || g.hash() != hashBefore || g.accumulators() != accumulatorsBefore) return -1;
+  return 0;
+}
+
+/*
+ * A search that makes and undoes more actions than the history holds leaves the history intact
+ */
+int undoActionTest8() {
+  GameCache cache = GameCache();
+  Game g = Game(cache);
+  GameHistory history;
+  std::vector<std::string> boards;
+  for(int ply = 0; ply < 4; ply++) {
+    boards.push_back(g.boardToString());
+    PlayerAction pa = g.usefulLegalActions()[ply];
+    history.makeAction(g, pa.moveSrcIdx, pa.moveDstIdx, pa.abilitySrcIdx, pa.abilityDstIdx);
+  }
+  std::string before = g.boardToString();
+  MctsConfig config = MctsConfig();
+  config.maxPlayouts = 50;
+  config.maxRolloutPlies = 2 * UNDO_HISTORY_LENGTH;
+  Mcts mcts = Mcts(config);
+  mcts.search(g);
+  if(g.boardToString() != before || history.length() != 4) return -1;
+  for(int ply = 3; ply >= 0; ply--) {
+    if(!history.undo(g) || g.boardToString() != boards[ply]) return -1;
+  }
+  return history.undo(g) ? -1 : 0;
+}
+
 int undoactionstest(int argc, char* argv[]) {
   int defaultchoice = 1;
   int choice = defaultchoice;
@@ -57,6 +221,18 @@ int undoactionstest(int argc, char* argv[]) {
     return undoActionTest1();
   case 2:
     return undoActionTest2();
+  case 3:
+    return undoActionTest3();
+  case 4:
+    return undoActionTest4();
+  case 5:
+    return undoActionTest5();
+  case 6:
+    return undoActionTest6();
+  case 7:
+    return undoActionTest7();
+  case 8:
+    return undoActionTest8();
   default:
     printf("\nInvalid test number.\n");
     return -1;